@@ -1,3 +1,9 @@
 #!/usr/bin/env bash
 cd /home/cosmic/mppcInterface/firmware/libraries/slowControl
-tail -f $(ls -t | head -n 1)
+newest=$(ls -t *.log | head -n 1)
+# logView renders binary logs (main -B) and passes text logs through
+if [ -x ./logView ]; then
+  ./logView -f "$newest"
+else
+  tail -f "$newest"
+fi
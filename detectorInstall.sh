@@ -118,9 +118,11 @@ build_dir "${REPO_TOP}/firmware/libraries/ice40"
 build_dir "${REPO_TOP}/firmware/libraries/max1932"
 
 log "Build slowControl (fix link order)"
-bash -lc "cd ${REPO_TOP}/firmware/libraries/slowControl && make clean || true && make -j\$(nproc) || true"
-# relink fallback with correct order and lib path
-bash -lc "cd ${REPO_TOP}/firmware/libraries/slowControl && rm -f main.o main && g++ -c main.cpp -std=c++11 -I. && g++ main.o -L/usr/local/lib -lwiringPi -lpthread -o main"
+bash -lc "cd ${REPO_TOP}/firmware/libraries/slowControl && make clean || true && make -j\$(nproc) main logView fpgaLayout || true"
+# relink fallback with explicit lib path (main is built from several objects now)
+bash -lc "cd ${REPO_TOP}/firmware/libraries/slowControl && [ -x main ] || make -j\$(nproc) main LDLIBS='-L/usr/local/lib -lwiringPi -lpthread'"
+# fpgaLayout writes coincidence.conf into the FPGA from rc.local at boot
+bash -lc "cd ${REPO_TOP}/firmware/libraries/slowControl && [ -x fpgaLayout ] || make fpgaLayout HAL_LDLIBS='-L/usr/local/lib -lwiringPi'"
 
 # ---- pigpio (daemon + CLI + python) from source in /usr/src ----
 log "Build & install pigpio from source"
@@ -0,0 +1,166 @@
+// coincidence.cpp — definitions and bookkeeping for CoincidenceEngine
+// - The per-hit work is inline in coincidence.h
+// - Delayed windows replay all but the lowest channel of each definition
+//   from per-channel history rings, cursors per definition and delay
+// Build: g++ -O2 -std=c++11 -c coincidence.cpp
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "coincidence.h"
+
+bool parseCoincidence(const char spec[], uint64_t window_ns, CoincidenceDef &def) {
+  std::memset(&def, 0, sizeof(def));
+  def.window_ns = window_ns;
+
+  const char *expr = std::strchr(spec, '=');
+  if (expr) {
+    size_t len = expr - spec;
+    if (len == 0 || len >= sizeof(def.name)) return false;
+    std::memcpy(def.name, spec, len);
+    expr++;
+  } else {
+    std::snprintf(def.name, sizeof(def.name), "%s", spec);
+    expr = spec;
+  }
+
+  // k-of-N: "k/c,c,c", all-of: "c&c&c"
+  const char *slash = std::strchr(expr, '/');
+  char sep = slash ? ',' : '&';
+  const char *p = slash ? slash + 1 : expr;
+  if (slash) {
+    // Checked before narrowing, "300/0,1" must not wrap to 44
+    char *end;
+    unsigned long k = std::strtoul(expr, &end, 10);
+    if (end == expr || end != slash || k == 0 || k > COINC_CHANNELS) return false;
+    def.k = (uint8_t)k;
+  }
+
+  while (*p) {
+    char *end;
+    unsigned long ch = std::strtoul(p, &end, 10);
+    if (end == p || ch >= COINC_CHANNELS) return false;
+    def.mask |= 1 << ch;
+    p = end;
+    if (*p == sep) p++;
+    else if (*p) return false;
+  }
+
+  uint8_t n = __builtin_popcount(def.mask);
+  if (!slash) def.k = n;
+  return n > 0 && def.k > 0 && def.k <= n;
+}
+
+CoincidenceEngine::CoincidenceEngine() {
+  _nDefs     = 0;
+  _everFired = 0;
+  _seen      = 0;
+  _hits      = 0;
+  _handler   = NULL;
+  _ctx       = NULL;
+  std::memset(_fired, 0, sizeof(_fired));
+  std::memset(_counts, 0, sizeof(_counts));
+  std::memset(_last, 0, sizeof(_last));
+  _nDelays     = 0;
+  _historyLost = 0;
+  std::memset(_delayed, 0, sizeof(_delayed));
+  std::memset(_historyWrite, 0, sizeof(_historyWrite));
+}
+
+bool CoincidenceEngine::add(const CoincidenceDef &def) {
+  if (_nDefs >= COINC_MAX_DEFS) return false;
+  uint8_t d = _nDefs++;
+  _defs[d] = def;
+  for (uint8_t k = 0; k < COINC_MAX_DELAYS; k++) resetDelayed(d, k);
+  return true;
+}
+
+bool CoincidenceEngine::addDelay(uint64_t delay_ns) {
+  if (_nDelays >= COINC_MAX_DELAYS || delay_ns == 0) return false;
+  uint8_t k = _nDelays++;
+  _delays[k] = delay_ns;
+  for (uint8_t d = 0; d < _nDefs; d++) resetDelayed(d, k);
+  return true;
+}
+
+// Off-time window starts from the hits still to come
+void CoincidenceEngine::resetDelayed(uint8_t d, uint8_t k) {
+  DelayState &s = _delayed[d][k];
+  std::memset(&s, 0, sizeof(s));
+  for (uint8_t c = 0; c < COINC_CHANNELS; c++) s.cursor[c] = _historyWrite[c];
+}
+
+double CoincidenceEngine::accidentals(uint8_t d) const {
+  if (_nDelays == 0) return 0;
+  uint64_t sum = 0;
+  for (uint8_t k = 0; k < _nDelays; k++) sum += _delayed[d][k].count;
+  return (double)sum / _nDelays;
+}
+
+// Shifted hits that fall at or before t, in time order across channels and
+// before t itself is counted, so _last[] holds exactly the on-time hits
+// preceding each replayed one
+void CoincidenceEngine::replayDelayed(uint64_t t) {
+  for (uint8_t d = 0; d < _nDefs; d++) {
+    uint8_t mask = _defs[d].mask;
+    uint8_t shifted = mask & (mask - 1);   // all but the lowest channel
+    for (uint8_t k = 0; k < _nDelays; k++) {
+      DelayState &s = _delayed[d][k];
+      while (1) {
+        uint8_t next = COINC_CHANNELS;
+        uint64_t nextT = t;
+        for (uint8_t c = 0; c < COINC_CHANNELS; c++) {
+          if (!(shifted >> c & 1)) continue;
+          uint32_t write = _historyWrite[c];
+          if (write - s.cursor[c] > COINC_HISTORY) {
+            _historyLost += write - s.cursor[c] - COINC_HISTORY;
+            s.cursor[c] = write - COINC_HISTORY;
+          }
+          if (s.cursor[c] == write) continue;
+          uint64_t at = _history[c][s.cursor[c] % COINC_HISTORY] + shift(d, c, k);
+          if (at <= nextT) {
+            next = c;
+            nextT = at;
+          }
+        }
+        if (next == COINC_CHANNELS) break;
+        s.cursor[next]++;
+        s.last[next] = nextT;
+        s.seen |= 1 << next;
+        evaluateDelayed(d, s, nextT);
+      }
+    }
+  }
+}
+
+// The on-time hit in every off-time window where its channel is unshifted,
+// then into the history
+void CoincidenceEngine::pushDelayed(uint8_t channel, uint64_t t) {
+  for (uint8_t d = 0; d < _nDefs; d++) {
+    if (channel != __builtin_ctz(_defs[d].mask)) continue;
+    for (uint8_t k = 0; k < _nDelays; k++) evaluateDelayed(d, _delayed[d][k], t);
+  }
+  _history[channel][_historyWrite[channel]++ % COINC_HISTORY] = t;
+}
+
+void CoincidenceEngine::evaluateDelayed(uint8_t d, DelayState &s, uint64_t t) {
+  const CoincidenceDef &def = _defs[d];
+  if (s.everFired && t - s.fired < def.window_ns) return;
+  uint8_t base = def.mask & -def.mask;
+  uint8_t m = liveMask(t, def.window_ns) & base;
+  for (uint8_t c = 0; c < COINC_CHANNELS; c++)
+    if ((def.mask & ~base & s.seen) >> c & 1 && t - s.last[c] < def.window_ns) m |= 1 << c;
+  if (__builtin_popcount(m) < def.k) return;
+  s.fired = t;
+  s.everFired = true;
+  s.count++;
+}
+
+void CoincidenceEngine::resetCounts() {
+  std::memset(_counts, 0, sizeof(_counts));
+  for (uint8_t d = 0; d < COINC_MAX_DEFS; d++)
+    for (uint8_t k = 0; k < COINC_MAX_DELAYS; k++) _delayed[d][k].count = 0;
+  _hits = 0;
+  _historyLost = 0;
+}
@@ -0,0 +1,141 @@
+// Host-side N-fold coincidence engine for raw channel hits (CH0-CH7).
+//
+// Hits are pushed in time order. A definition fires on a hit when the
+// channels in its mask with a hit inside the last window_ns satisfy it
+// (k of them for k-of-N, all of them for a named AND), and it has not
+// already fired inside that window. That matches counting rising edges of
+// the FPGA's AND of stretched pulses, without building bitstreams.
+//
+// State is one timestamp per channel and per definition, so memory does not
+// grow with rate or window.
+//
+// Accidentals are estimated with delayed windows: for each delay D, every
+// definition is also evaluated with its channels shifted late by 0, D, 2D,
+// ... in channel order. Real coincidences cannot survive the shift, even
+// between a subset of channels for k-of-N, while random ones occur at the
+// same rate, so the off-time count estimates the accidentals in the on-time
+// one. Shifted hits are replayed from the last COINC_HISTORY hits of each
+// channel; hits that fall out before their turn are historyLost().
+#ifndef __COINCIDENCE_H__
+#define __COINCIDENCE_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define COINC_CHANNELS 8
+#define COINC_MAX_DEFS 32
+#define COINC_MAX_DELAYS 4
+#define COINC_HISTORY 256      // hits per channel kept for delayed windows
+
+struct CoincidenceDef {
+  char     name[24];
+  uint8_t  mask;       // bit c = CHc takes part
+  uint8_t  k;          // channels needed, popcount(mask) for an AND
+  uint64_t window_ns;
+};
+
+// "name=0&1&2" (all of), "name=2/0,1,2,3" (2 of 0..3) or without "name=".
+// Returns false on a malformed spec.
+bool parseCoincidence(const char spec[], uint64_t window_ns, CoincidenceDef &def);
+
+class CoincidenceEngine {
+ public:
+  // Optional, called for every coincidence with the time of the hit that made it
+  typedef void (*CoincidenceHandler)(uint8_t def, uint64_t timestamp_ns, void *ctx);
+
+  CoincidenceEngine();
+
+  bool add(const CoincidenceDef &def);
+  void onCoincidence(CoincidenceHandler handler, void *ctx);
+
+  // Off-time window delayed by delay_ns, which should be well above every
+  // window and any real correlation time
+  bool addDelay(uint64_t delay_ns);
+
+  // One hit, timestamps must not go backwards
+  inline void push(uint8_t channel, uint64_t timestamp_ns) {
+    uint8_t bit = 1 << channel;
+    if (_nDelays) replayDelayed(timestamp_ns);
+    _last[channel] = timestamp_ns;
+    _seen |= bit;
+    _hits++;
+    for (uint8_t d = 0; d < _nDefs; d++) {
+      const CoincidenceDef &def = _defs[d];
+      if (!(def.mask & bit)) continue;
+      if ((_everFired >> d & 1) && timestamp_ns - _fired[d] < def.window_ns) continue;
+      if (__builtin_popcount(liveMask(timestamp_ns, def.window_ns) & def.mask) < def.k) continue;
+      _fired[d] = timestamp_ns;
+      _everFired |= 1u << d;
+      _counts[d]++;
+      if (_handler) _handler(d, timestamp_ns, _ctx);
+    }
+    if (_nDelays) pushDelayed(channel, timestamp_ns);
+  }
+
+  uint8_t definitions() const { return _nDefs; }
+  const CoincidenceDef &definition(uint8_t d) const { return _defs[d]; }
+  uint64_t count(uint8_t d) const { return _counts[d]; }
+  uint64_t hits() const { return _hits; }
+
+  uint8_t delays() const { return _nDelays; }
+  uint64_t delay(uint8_t k) const { return _delays[k]; }
+  // Off-time coincidences of definition d in delayed window k
+  uint64_t delayedCount(uint8_t d, uint8_t k) const { return _delayed[d][k].count; }
+  // Mean over all delays, the accidental estimate for count(d)
+  double accidentals(uint8_t d) const;
+  uint64_t historyLost() const { return _historyLost; }
+
+  // Zero the counts, keeps the hit history so windows span the reset
+  void resetCounts();
+
+ private:
+
+  struct DelayState {
+    uint64_t last[COINC_CHANNELS];     // latest shifted hit per channel
+    uint32_t cursor[COINC_CHANNELS];   // next history entry to replay
+    uint64_t fired;
+    uint64_t count;
+    uint8_t seen;
+    bool everFired;
+  };
+
+  // Shift of channel c in definition d's off-time window k
+  inline uint64_t shift(uint8_t d, uint8_t c, uint8_t k) const {
+    return __builtin_popcount(_defs[d].mask & ((1 << c) - 1)) * _delays[k];
+  }
+
+  void replayDelayed(uint64_t t);
+  void pushDelayed(uint8_t channel, uint64_t t);
+  void resetDelayed(uint8_t d, uint8_t k);
+  void evaluateDelayed(uint8_t d, DelayState &s, uint64_t t);
+
+  // Channels with a hit in (t - window, t]
+  inline uint8_t liveMask(uint64_t t, uint64_t window) const {
+    uint8_t m = 0;
+    for (int c = 0; c < COINC_CHANNELS; c++)
+      if (t - _last[c] < window) m |= 1 << c;
+    return m & _seen;
+  }
+
+  CoincidenceDef _defs[COINC_MAX_DEFS];
+  uint64_t _fired[COINC_MAX_DEFS];
+  uint64_t _counts[COINC_MAX_DEFS];
+  uint32_t _everFired;
+  uint8_t _nDefs;
+
+  uint64_t _last[COINC_CHANNELS];
+  uint8_t _seen;
+  uint64_t _hits;
+
+  uint64_t _delays[COINC_MAX_DELAYS];
+  uint8_t _nDelays;
+  DelayState _delayed[COINC_MAX_DEFS][COINC_MAX_DELAYS];
+  uint64_t _history[COINC_CHANNELS][COINC_HISTORY];
+  uint32_t _historyWrite[COINC_CHANNELS];
+  uint64_t _historyLost;
+
+  CoincidenceHandler _handler;
+  void *_ctx;
+};
+
+#endif //__COINCIDENCE_H__
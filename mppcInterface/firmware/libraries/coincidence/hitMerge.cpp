@@ -0,0 +1,153 @@
+// hitMerge.cpp — hit sources and the streaming k-way merge
+// - Binary min-heap over the channel heads, one sift per hit
+// - Event files are mapped, each channel walks the records on its own
+// Build: g++ -O2 -std=c++11 -I../slowControl -c hitMerge.cpp
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "eventWriter.h"
+#include "hitMerge.h"
+
+EventFile::EventFile() {
+  _map = NULL;
+  _length = 0;
+  _events = NULL;
+  _records = 0;
+  _realtimeOffset = 0;
+}
+
+EventFile::~EventFile() {
+  if (_map) munmap(const_cast<uint8_t *>(_map), _length);
+}
+
+bool EventFile::open(const char filename[]) {
+  int fd = ::open(filename, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    std::perror(filename);
+    return false;
+  }
+  struct stat st;
+  fstat(fd, &st);
+  _length = st.st_size;
+  if (_length < sizeof(EventFileHeader)) {
+    std::fprintf(stderr, "ERROR: %s is too short for an event file\n", filename);
+    close(fd);
+    return false;
+  }
+
+  void *map = mmap(NULL, _length, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    std::perror("mmap event file");
+    return false;
+  }
+  _map = static_cast<const uint8_t *>(map);
+  madvise(map, _length, MADV_SEQUENTIAL);
+
+  const EventFileHeader *header = reinterpret_cast<const EventFileHeader *>(_map);
+  if (std::memcmp(header->magic, EVENT_FILE_MAGIC, sizeof(header->magic)) != 0 ||
+      header->recordSize != sizeof(EdgeEvent)) {
+    std::fprintf(stderr, "ERROR: %s is not a slowControl event file\n", filename);
+    return false;
+  }
+  _realtimeOffset = header->realtimeOffset_ns;
+  _events  = reinterpret_cast<const EdgeEvent *>(_map + sizeof(EventFileHeader));
+  _records = (_length - sizeof(EventFileHeader)) / sizeof(EdgeEvent);
+  return true;
+}
+
+size_t EventFileChannel::read(uint64_t *out, size_t max) {
+  size_t n = 0;
+  size_t records = _file.records();
+  while (n < max && _pos < records) {
+    const EdgeEvent *e = _file.record(_pos++);
+    if (e->channel == _counter) out[n++] = e->timestamp_ns;
+  }
+  return n;
+}
+
+PoissonSource::PoissonSource(double rate_hz, uint64_t duration_ns, uint64_t seed) {
+  _meanGap_ns = 1e9 / rate_hz;
+  _end_ns = duration_ns;
+  _t = 0;
+  _state = seed * 0x9E3779B97F4A7C15ULL + 1;
+}
+
+size_t PoissonSource::read(uint64_t *out, size_t max) {
+  size_t n = 0;
+  while (n < max) {
+    // xorshift64*, exponential gaps
+    _state ^= _state >> 12;
+    _state ^= _state << 25;
+    _state ^= _state >> 27;
+    double u = ((_state * 0x2545F4914F6CDD1DULL) >> 11) * (1.0 / 9007199254740992.0);
+    _t += -std::log(1.0 - u) * _meanGap_ns;
+    if (_t >= _end_ns) break;
+    out[n++] = (uint64_t)_t;
+  }
+  return n;
+}
+
+KWayMerge::KWayMerge() {
+  _nStreams = 0;
+  _heapSize = 0;
+}
+
+KWayMerge::~KWayMerge() {
+  for (size_t i = 0; i < _nStreams; i++) delete[] _streams[i].block;
+}
+
+bool KWayMerge::add(HitSource *source, uint8_t channel) {
+  if (_nStreams >= COINC_CHANNELS || channel >= COINC_CHANNELS) return false;
+  Stream &s = _streams[_nStreams++];
+  s.source  = source;
+  s.channel = channel;
+  s.block   = new uint64_t[MERGE_BLOCK];
+  s.used    = 0;
+  s.pos     = 0;
+  return true;
+}
+
+bool KWayMerge::refill(Stream &s) {
+  s.used = s.source->read(s.block, MERGE_BLOCK);
+  s.pos = 0;
+  return s.used > 0;
+}
+
+void KWayMerge::siftDown(size_t i) {
+  while (1) {
+    size_t l = 2 * i + 1, r = l + 1, m = i;
+    if (l < _heapSize && head(l) < head(m)) m = l;
+    if (r < _heapSize && head(r) < head(m)) m = r;
+    if (m == i) return;
+    uint8_t tmp = _heap[i];
+    _heap[i] = _heap[m];
+    _heap[m] = tmp;
+    i = m;
+  }
+}
+
+uint64_t KWayMerge::run(CoincidenceEngine &engine) {
+  _heapSize = 0;
+  for (size_t i = 0; i < _nStreams; i++)
+    if (refill(_streams[i])) _heap[_heapSize++] = i;
+  for (size_t i = _heapSize; i-- > 0;) siftDown(i);
+
+  uint64_t merged = 0;
+  while (_heapSize > 0) {
+    Stream &s = _streams[_heap[0]];
+    engine.push(s.channel, s.block[s.pos]);
+    merged++;
+
+    if (++s.pos == s.used && !refill(s)) _heap[0] = _heap[--_heapSize];
+    siftDown(0);
+  }
+  return merged;
+}
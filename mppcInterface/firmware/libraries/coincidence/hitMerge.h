@@ -0,0 +1,98 @@
+// Per-channel hit streams and the k-way merge that feeds CoincidenceEngine.
+// Every source is read in blocks of MERGE_BLOCK timestamps, so memory is
+// bounded by channels x block no matter how long the run is.
+#ifndef __HITMERGE_H__
+#define __HITMERGE_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "coincidence.h"
+#include "eventRing.h"
+
+#define MERGE_BLOCK 4096
+
+// Sorted timestamps of one channel
+class HitSource {
+ public:
+  virtual ~HitSource() {}
+  // Up to max timestamps, 0 once the stream is exhausted
+  virtual size_t read(uint64_t *out, size_t max) = 0;
+};
+
+// A slowControl event file (main -e), mapped read-only
+class EventFile {
+ public:
+  EventFile();
+  ~EventFile();
+
+  bool open(const char filename[]);
+  size_t records() const { return _records; }
+  const EdgeEvent *record(size_t i) const { return _events + i; }
+  int64_t realtimeOffset_ns() const { return _realtimeOffset; }
+
+ private:
+  const uint8_t *_map;
+  size_t _length;
+  const EdgeEvent *_events;
+  size_t _records;
+  int64_t _realtimeOffset;
+};
+
+// The hits of one slowControl counter in an event file
+class EventFileChannel : public HitSource {
+ public:
+  EventFileChannel(const EventFile &file, uint8_t counter) : _file(file), _counter(counter), _pos(0) {}
+  size_t read(uint64_t *out, size_t max);
+
+ private:
+  const EventFile &_file;
+  uint8_t _counter;
+  size_t _pos;
+};
+
+// Uncorrelated Poisson hits for throughput tests
+class PoissonSource : public HitSource {
+ public:
+  PoissonSource(double rate_hz, uint64_t duration_ns, uint64_t seed);
+  size_t read(uint64_t *out, size_t max);
+
+ private:
+  double _meanGap_ns;
+  uint64_t _end_ns;
+  double _t;
+  uint64_t _state;
+};
+
+class KWayMerge {
+ public:
+  KWayMerge();
+  ~KWayMerge();
+
+  bool add(HitSource *source, uint8_t channel);
+
+  // Push every hit of every source into the engine in time order,
+  // returns the number of hits merged
+  uint64_t run(CoincidenceEngine &engine);
+
+ private:
+
+  struct Stream {
+    HitSource *source;
+    uint8_t channel;
+    uint64_t *block;
+    size_t used;
+    size_t pos;
+  };
+
+  bool refill(Stream &s);
+  void siftDown(size_t i);
+  uint64_t head(size_t i) const { return _streams[_heap[i]].block[_streams[_heap[i]].pos]; }
+
+  Stream _streams[COINC_CHANNELS];
+  uint8_t _heap[COINC_CHANNELS];
+  size_t _nStreams;
+  size_t _heapSize;
+};
+
+#endif //__HITMERGE_H__
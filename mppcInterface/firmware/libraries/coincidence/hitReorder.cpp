@@ -0,0 +1,54 @@
+// hitReorder.cpp — bounded-lag merge of live per-channel hit queues
+// - One ring per channel, merged by scanning the channel heads
+// - Released once per lag/4 of progress, not on every hit
+// - A full ring releases up to its own oldest hit instead of dropping it
+// Build: g++ -O2 -std=c++11 -c hitReorder.cpp
+
+#include <cstring>
+
+#include "hitReorder.h"
+
+HitReorder::HitReorder(CoincidenceEngine &engine, uint64_t lag_ns) : _engine(engine) {
+  _lag      = lag_ns;
+  _released = 0;
+  _newest   = 0;
+  _late     = 0;
+  std::memset(_head, 0, sizeof(_head));
+  std::memset(_tail, 0, sizeof(_tail));
+}
+
+void HitReorder::push(uint8_t channel, uint64_t timestamp_ns) {
+  if (channel >= COINC_CHANNELS || timestamp_ns < _released) {
+    _late++;
+    return;
+  }
+  if (_head[channel] - _tail[channel] == REORDER_DEPTH)
+    release(_held[channel][_tail[channel] % REORDER_DEPTH] + 1);
+  _held[channel][_head[channel]++ % REORDER_DEPTH] = timestamp_ns;
+
+  if (timestamp_ns > _newest) _newest = timestamp_ns;
+  if (_newest > _released + _lag + _lag / 4) release(_newest - _lag);
+}
+
+void HitReorder::flush() {
+  release(_newest + 1);
+}
+
+void HitReorder::release(uint64_t before_ns) {
+  while (1) {
+    uint8_t next = COINC_CHANNELS;
+    uint64_t nextT = before_ns;
+    for (uint8_t c = 0; c < COINC_CHANNELS; c++) {
+      if (_head[c] == _tail[c]) continue;
+      uint64_t t = _held[c][_tail[c] % REORDER_DEPTH];
+      if (t < nextT) {
+        next = c;
+        nextT = t;
+      }
+    }
+    if (next == COINC_CHANNELS) break;
+    _tail[next]++;
+    _engine.push(next, nextT);
+  }
+  if (before_ns > _released) _released = before_ns;
+}
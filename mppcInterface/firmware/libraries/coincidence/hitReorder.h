@@ -0,0 +1,42 @@
+// Puts live hits from separate per-channel queues back into time order.
+//
+// Each channel's hits arrive in order, but channels are read in batches at
+// different moments. Hits are held until they are lag_ns older than the
+// newest one seen, then merged into the engine. A hit that arrives after
+// its moment has passed is counted as late and left out.
+#ifndef __HITREORDER_H__
+#define __HITREORDER_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "coincidence.h"
+
+#define REORDER_DEPTH 8192   // hits held per channel
+
+class HitReorder {
+ public:
+  HitReorder(CoincidenceEngine &engine, uint64_t lag_ns);
+
+  void push(uint8_t channel, uint64_t timestamp_ns);
+  // Release everything held
+  void flush();
+
+  uint64_t late() const { return _late; }
+
+ private:
+
+  void release(uint64_t before_ns);
+
+  CoincidenceEngine &_engine;
+  uint64_t _lag;
+  uint64_t _released;   // hits before this went to the engine
+  uint64_t _newest;
+  uint64_t _late;
+
+  uint64_t _held[COINC_CHANNELS][REORDER_DEPTH];
+  uint32_t _head[COINC_CHANNELS];
+  uint32_t _tail[COINC_CHANNELS];
+};
+
+#endif //__HITREORDER_H__
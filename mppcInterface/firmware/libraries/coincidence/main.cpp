@@ -0,0 +1,118 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <chrono>
+
+#include "coincidence.h"
+#include "hitMerge.h"
+
+// Reprocess raw hits under any set of coincidence definitions.
+//
+//   ./main [-w window_ns] [-D delay_ns,...] [-r 4,5,6] -c name=expr [-c ...] <events.bin>
+//   ./main -b <rate_hz> [-n channels] [-t seconds] [-w window_ns] [-D ...] -c ...
+//
+// expr is "0&1&2" (all of) or "2/0,1,2" (2 of). -r lists which slowControl
+// counters hold raw CH0, CH1, ... in the event file (default 4,5,6).
+// -D adds delayed windows and reports accidentals and net counts.
+// -b runs on synthetic Poisson hits instead, to measure throughput.
+
+int main(int argc, char** argv) {
+  uint64_t window = 1000;
+  const char* specs[COINC_MAX_DEFS];
+  int nSpecs = 0;
+  const char* rawCounters = "4,5,6";
+  const char* delays = NULL;
+  double benchRate = 0;
+  int benchChannels = 3;
+  double benchSeconds = 10;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "w:c:r:b:n:t:D:")) != -1) {
+    switch (opt) {
+    case 'w': window = strtoull(optarg, NULL, 10); break;
+    case 'c':
+      if (nSpecs == COINC_MAX_DEFS) {
+        fprintf(stderr, "At most %d coincidences, '%s' is one too many\n", COINC_MAX_DEFS, optarg);
+        return 1;
+      }
+      specs[nSpecs++] = optarg;
+      break;
+    case 'r': rawCounters = optarg; break;
+    case 'D': delays = optarg; break;
+    case 'b': benchRate = atof(optarg); break;
+    case 'n': benchChannels = atoi(optarg); break;
+    case 't': benchSeconds = atof(optarg); break;
+    default:  nSpecs = 0; break;
+    }
+  }
+  if (nSpecs == 0 || (benchRate <= 0 && optind >= argc)) {
+    fprintf(stderr, "Usage: %s [-w window_ns] [-D delay_ns,...] [-r 4,5,6] -c name=expr [-c ...] <events.bin>\n"
+                    "       %s -b rate_hz [-n channels] [-t seconds] [-w window_ns] [-D ...] -c ...\n",
+            argv[0], argv[0]);
+    return 1;
+  }
+
+  CoincidenceEngine engine;
+  for (int i = 0; i < nSpecs; i++) {
+    CoincidenceDef def;
+    if (!parseCoincidence(specs[i], window, def)) {
+      fprintf(stderr, "Bad coincidence '%s'\n", specs[i]);
+      return 1;
+    }
+    engine.add(def);
+  }
+  for (const char* p = delays; p && *p;) {
+    char* end;
+    uint64_t delay = strtoull(p, &end, 10);
+    if (end == p || !engine.addDelay(delay)) {
+      fprintf(stderr, "Bad delay list '%s'\n", delays);
+      return 1;
+    }
+    p = *end == ',' ? end + 1 : end;
+  }
+
+  KWayMerge merge;
+  EventFile file;
+  HitSource* sources[COINC_CHANNELS];
+  int nSources = 0;
+
+  if (benchRate > 0) {
+    uint64_t duration = (uint64_t)(benchSeconds * 1e9);
+    for (int ch = 0; ch < benchChannels && ch < COINC_CHANNELS; ch++) {
+      sources[nSources] = new PoissonSource(benchRate, duration, ch + 1);
+      merge.add(sources[nSources++], ch);
+    }
+  } else {
+    if (!file.open(argv[optind])) return 1;
+    const char* p = rawCounters;
+    while (*p && nSources < COINC_CHANNELS) {
+      char* end;
+      int counter = strtol(p, &end, 10);
+      if (end == p) break;
+      sources[nSources] = new EventFileChannel(file, counter);
+      merge.add(sources[nSources], nSources);
+      nSources++;
+      p = *end == ',' ? end + 1 : end;
+    }
+  }
+
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+  uint64_t hits = merge.run(engine);
+  double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+  printf("%llu hits on %d channels, window %llu ns, %.2f M hits/s\n",
+         (unsigned long long)hits, nSources, (unsigned long long)window, hits / elapsed / 1e6);
+  for (uint8_t d = 0; d < engine.definitions(); d++) {
+    printf("%-16s %llu", engine.definition(d).name, (unsigned long long)engine.count(d));
+    if (engine.delays())
+      printf("  accidental %.1f  net %.1f", engine.accidentals(d), engine.count(d) - engine.accidentals(d));
+    printf("\n");
+  }
+  if (engine.historyLost())
+    fprintf(stderr, "%llu hits fell out of the delay history, shorten -D\n",
+            (unsigned long long)engine.historyLost());
+
+  for (int i = 0; i < nSources; i++) delete sources[i];
+  return 0;
+}
@@ -0,0 +1,112 @@
+// windowBench.cpp — windowMatch() against the scalar merge on synthetic hits
+// - Every channel: shared muon hits plus its own dark counts, both Poisson
+// - Checks the two paths agree, then reports hits/s and a year's run time
+// Build: make windowBench
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "hitMerge.h"
+#include "windowMatch.h"
+
+typedef void (*MatchFn)(const uint64_t *const[], const size_t[], int, int, uint64_t, uint8_t *);
+
+static std::vector<uint64_t> drain(HitSource &source) {
+  std::vector<uint64_t> out;
+  uint64_t block[MERGE_BLOCK];
+  size_t n;
+  while ((n = source.read(block, MERGE_BLOCK)) > 0) out.insert(out.end(), block, block + n);
+  return out;
+}
+
+static double timeMatch(MatchFn fn, const uint64_t *const hits[], const size_t counts[],
+                        int channels, uint64_t dt, uint8_t *masks, int reps) {
+  double best = 1e30;
+  for (int r = 0; r < reps; r++) {
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    fn(hits, counts, channels, 0, dt, masks);
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    if (s < best) best = s;
+  }
+  return best;
+}
+
+int main(int argc, char** argv) {
+  int channels = 3;
+  double muonRate = 50;
+  double darkRate = 200000;
+  double seconds = 60;
+  uint64_t dt = 100;
+  int reps = 5;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "n:m:d:t:w:r:")) != -1) {
+    switch (opt) {
+    case 'n': channels = atoi(optarg); break;
+    case 'm': muonRate = atof(optarg); break;
+    case 'd': darkRate = atof(optarg); break;
+    case 't': seconds = atof(optarg); break;
+    case 'w': dt = strtoull(optarg, NULL, 10); break;
+    case 'r': reps = atoi(optarg); break;
+    default:
+      fprintf(stderr, "Usage: %s [-n channels] [-m muon_hz] [-d dark_hz] [-t seconds] [-w dt_ns] [-r reps]\n", argv[0]);
+      return 1;
+    }
+  }
+  if (channels < 2 || channels > COINC_CHANNELS) {
+    fprintf(stderr, "Channels must be 2-%d\n", COINC_CHANNELS);
+    return 1;
+  }
+
+  uint64_t duration = (uint64_t)(seconds * 1e9);
+  PoissonSource muonSource(muonRate, duration, 1000);
+  std::vector<uint64_t> muons = drain(muonSource);
+
+  std::vector<uint64_t> streams[COINC_CHANNELS];
+  const uint64_t* hits[COINC_CHANNELS];
+  size_t counts[COINC_CHANNELS];
+  size_t total = 0;
+  for (int c = 0; c < channels; c++) {
+    PoissonSource darkSource(darkRate, duration, c + 1);
+    std::vector<uint64_t> dark = drain(darkSource);
+    std::vector<uint64_t> shifted(muons);
+    for (size_t i = 0; i < shifted.size(); i++) shifted[i] += 2 * c;   // small per-channel delay
+    streams[c].resize(dark.size() + shifted.size());
+    std::merge(dark.begin(), dark.end(), shifted.begin(), shifted.end(), streams[c].begin());
+    hits[c] = streams[c].data();
+    counts[c] = streams[c].size();
+    total += counts[c];
+  }
+
+  std::vector<uint8_t> scalarMasks(counts[0]), simdMasks(counts[0]);
+  double scalarTime = timeMatch(windowMatchScalar, hits, counts, channels, dt, scalarMasks.data(), reps);
+  double simdTime   = timeMatch(windowMatch, hits, counts, channels, dt, simdMasks.data(), reps);
+
+  if (scalarMasks != simdMasks) {
+    fprintf(stderr, "ERROR: %s path disagrees with the scalar merge\n", windowMatchPath());
+    return 1;
+  }
+
+  uint8_t all = (1 << channels) - 1;
+  uint64_t allOf = 0, twoOf = 0;
+  for (size_t i = 0; i < counts[0]; i++) {
+    int n = __builtin_popcount(simdMasks[i] & all);
+    if (n == channels) allOf++;
+    if (n >= 2) twoOf++;
+  }
+
+  printf("%d channels, %.0f s, muons %.0f Hz, dark %.0f Hz/channel, dt %llu ns\n",
+         channels, seconds, muonRate, darkRate, (unsigned long long)dt);
+  printf("%zu hits, CH0 hits with all channels %llu, with 2+ %llu (muons %zu)\n",
+         total, (unsigned long long)allOf, (unsigned long long)twoOf, muons.size());
+  printf("scalar  %8.2f M hits/s\n", total / scalarTime / 1e6);
+  printf("%-7s %8.2f M hits/s  x%.2f\n", windowMatchPath(), total / simdTime / 1e6, scalarTime / simdTime);
+  printf("one year at these rates: scalar %.0f s, %s %.0f s\n",
+         scalarTime / seconds * 365.25 * 86400, windowMatchPath(), simdTime / seconds * 365.25 * 86400);
+  return 0;
+}
@@ -0,0 +1,157 @@
+// windowMatch.cpp — SIMD window matching kernels
+// - Reference hits go in blocks of LANES, each candidate hit of another
+//   channel is broadcast and compared against every lane's [t-dt, t+dt]
+// - Candidates below the block's first window are skipped LANES at a time
+// - Leftover reference hits, and builds without AVX2/NEON, use the scalar merge
+// Build: g++ -O2 -std=c++11 [-mavx2] -c windowMatch.cpp
+
+#include <cstring>
+
+#include "windowMatch.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define LANES 4
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define LANES 2
+#endif
+
+static inline uint64_t windowStart(uint64_t t, uint64_t dt) {
+  return t > dt ? t - dt : 0;
+}
+
+// Reference hits [from, to) against every channel, pos[] = first candidate
+static void matchScalar(const uint64_t *const hits[], const size_t counts[], int channels,
+                        int ref, uint64_t dt, uint8_t *masks, size_t from, size_t to,
+                        size_t pos[]) {
+  const uint64_t *r = hits[ref];
+  for (size_t i = from; i < to; i++) {
+    uint64_t lo = windowStart(r[i], dt);
+    uint64_t hi = r[i] + dt;
+    uint8_t m = 1 << ref;
+    for (int c = 0; c < channels; c++) {
+      if (c == ref) continue;
+      const uint64_t *x = hits[c];
+      size_t p = pos[c], n = counts[c];
+      while (p < n && x[p] < lo) p++;
+      pos[c] = p;
+      if (p < n && x[p] <= hi) m |= 1 << c;
+    }
+    masks[i] = m;
+  }
+}
+
+void windowMatchScalar(const uint64_t *const hits[], const size_t counts[], int channels,
+                       int ref, uint64_t dt_ns, uint8_t *masks) {
+  size_t pos[COINC_CHANNELS] = {0};
+  matchScalar(hits, counts, channels, ref, dt_ns, masks, 0, counts[ref], pos);
+}
+
+#ifdef LANES
+
+#if defined(__AVX2__)
+
+// First index >= p whose value is not below lo
+static inline size_t skipBelow(const uint64_t *x, size_t p, size_t n, uint64_t lo) {
+  __m256i vlo = _mm256_set1_epi64x(lo);
+  while (p + 4 <= n) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(x + p));
+    int below = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(vlo, v)));
+    if (below != 0xF) return p + __builtin_popcount(below);
+    p += 4;
+  }
+  while (p < n && x[p] < lo) p++;
+  return p;
+}
+
+// Bit l set when lane l has a candidate in x[p..] inside its window
+static inline int matchBlock(const uint64_t *x, size_t p, size_t n,
+                             const uint64_t lo[LANES], const uint64_t hi[LANES]) {
+  __m256i vlo = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(lo));
+  __m256i vhi = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(hi));
+  __m256i any = _mm256_setzero_si256();
+  __m256i ones = _mm256_set1_epi64x(-1);
+  uint64_t last = hi[LANES - 1];
+  for (; p < n && x[p] <= last; p++) {
+    __m256i v = _mm256_set1_epi64x(x[p]);
+    __m256i out = _mm256_or_si256(_mm256_cmpgt_epi64(vlo, v), _mm256_cmpgt_epi64(v, vhi));
+    any = _mm256_or_si256(any, _mm256_andnot_si256(out, ones));
+  }
+  return _mm256_movemask_pd(_mm256_castsi256_pd(any));
+}
+
+#else
+
+static inline size_t skipBelow(const uint64_t *x, size_t p, size_t n, uint64_t lo) {
+  uint64x2_t vlo = vdupq_n_u64(lo);
+  while (p + 2 <= n) {
+    uint64x2_t below = vcltq_u64(vld1q_u64(x + p), vlo);
+    if (!vgetq_lane_u64(below, 0)) return p;
+    if (!vgetq_lane_u64(below, 1)) return p + 1;
+    p += 2;
+  }
+  while (p < n && x[p] < lo) p++;
+  return p;
+}
+
+static inline int matchBlock(const uint64_t *x, size_t p, size_t n,
+                             const uint64_t lo[LANES], const uint64_t hi[LANES]) {
+  uint64x2_t vlo = vld1q_u64(lo);
+  uint64x2_t vhi = vld1q_u64(hi);
+  uint64x2_t any = vdupq_n_u64(0);
+  uint64_t last = hi[LANES - 1];
+  for (; p < n && x[p] <= last; p++) {
+    uint64x2_t v = vdupq_n_u64(x[p]);
+    any = vorrq_u64(any, vandq_u64(vcgeq_u64(v, vlo), vcleq_u64(v, vhi)));
+  }
+  return (vgetq_lane_u64(any, 0) & 1) | (vgetq_lane_u64(any, 1) & 2);
+}
+
+#endif
+
+void windowMatch(const uint64_t *const hits[], const size_t counts[], int channels,
+                 int ref, uint64_t dt_ns, uint8_t *masks) {
+  size_t pos[COINC_CHANNELS] = {0};
+  const uint64_t *r = hits[ref];
+  size_t nRef = counts[ref];
+  size_t blocks = nRef / LANES * LANES;
+  uint64_t lo[LANES], hi[LANES];
+
+  for (size_t i = 0; i < blocks; i += LANES) {
+    for (int l = 0; l < LANES; l++) {
+      lo[l] = windowStart(r[i + l], dt_ns);
+      hi[l] = r[i + l] + dt_ns;
+      masks[i + l] = 1 << ref;
+    }
+    for (int c = 0; c < channels; c++) {
+      if (c == ref) continue;
+      size_t p = pos[c] = skipBelow(hits[c], pos[c], counts[c], lo[0]);
+      int m = matchBlock(hits[c], p, counts[c], lo, hi);
+      for (int l = 0; l < LANES; l++)
+        if (m >> l & 1) masks[i + l] |= 1 << c;
+    }
+  }
+  matchScalar(hits, counts, channels, ref, dt_ns, masks, blocks, nRef, pos);
+}
+
+const char *windowMatchPath() {
+#if defined(__AVX2__)
+  return "avx2";
+#else
+  return "neon";
+#endif
+}
+
+#else
+
+void windowMatch(const uint64_t *const hits[], const size_t counts[], int channels,
+                 int ref, uint64_t dt_ns, uint8_t *masks) {
+  windowMatchScalar(hits, counts, channels, ref, dt_ns, masks);
+}
+
+const char *windowMatchPath() {
+  return "scalar";
+}
+
+#endif
@@ -0,0 +1,29 @@
+// Batch window matching over sorted per-channel timestamp arrays.
+//
+// For every hit of a reference channel, finds which channels have a hit
+// within +-dt of it. masks[i] gets bit c for each such channel c (the
+// reference bit is always set), so a k-of-N condition on hit i is
+// popcount(masks[i] & mask) >= k.
+//
+// windowMatch() takes the fastest path built in (AVX2 on x86, NEON on
+// AArch64) and tests a block of reference hits against each candidate at
+// once. windowMatchScalar() is the plain two-pointer merge, kept as the
+// reference. Both give identical masks. Timestamps must be below 2^63.
+#ifndef __WINDOWMATCH_H__
+#define __WINDOWMATCH_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "coincidence.h"
+
+void windowMatch(const uint64_t *const hits[], const size_t counts[], int channels,
+                 int ref, uint64_t dt_ns, uint8_t *masks);
+
+void windowMatchScalar(const uint64_t *const hits[], const size_t counts[], int channels,
+                       int ref, uint64_t dt_ns, uint8_t *masks);
+
+// "avx2", "neon" or "scalar"
+const char *windowMatchPath();
+
+#endif //__WINDOWMATCH_H__
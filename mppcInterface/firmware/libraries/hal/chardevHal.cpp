@@ -0,0 +1,210 @@
+// chardevHal.cpp — gpiod/spidev/i2c-dev implementation of the HAL
+// - A pin's line is re-requested when its direction, bias or edge changes
+// - Short delays spin on CLOCK_MONOTONIC like wiringPi, long ones sleep
+// - Edge threads block in the kernel and are never joined, as in wiringPi
+// Build: g++ -O2 -std=c++11 -DHAL_BACKEND_CHARDEV -c chardevHal.cpp (link -lgpiod -lpthread)
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/spi/spidev.h>
+#include <linux/i2c-dev.h>
+#include <gpiod.h>
+
+#include "chardevHal.h"
+
+#define GPIO_CHIP "/dev/gpiochip0"
+
+ChardevHal::ChardevHal() {
+  _chip = NULL;
+  for (int i = 0; i < HAL_MAX_PINS; i++) {
+    _lines[i] = NULL;
+    _mode[i]  = HAL_INPUT;
+    _pull[i]  = HAL_PULL_OFF;
+    _edge[i]  = false;
+  }
+  for (int i = 0; i < HAL_SPI_CHANNELS; i++) {
+    _spiFd[i]    = -1;
+    _spiSpeed[i] = 0;
+  }
+}
+
+ChardevHal::~ChardevHal() {
+  for (int i = 0; i < HAL_MAX_PINS; i++)
+    if (_lines[i] && !_edge[i]) gpiod_line_request_release(_lines[i]);
+  for (int i = 0; i < HAL_SPI_CHANNELS; i++)
+    if (_spiFd[i] >= 0) close(_spiFd[i]);
+  if (_chip) gpiod_chip_close(_chip);
+}
+
+bool ChardevHal::setup() {
+  if (_chip) return true;
+  _chip = gpiod_chip_open(GPIO_CHIP);
+  if (!_chip) {
+    std::perror(GPIO_CHIP);
+    return false;
+  }
+  return true;
+}
+
+bool ChardevHal::request(unsigned pin) {
+  if (pin >= HAL_MAX_PINS || (!_chip && !setup())) return false;
+  if (_lines[pin]) {
+    gpiod_line_request_release(_lines[pin]);
+    _lines[pin] = NULL;
+  }
+
+  struct gpiod_line_settings *settings = gpiod_line_settings_new();
+  struct gpiod_line_config *lineCfg = gpiod_line_config_new();
+  struct gpiod_request_config *reqCfg = gpiod_request_config_new();
+  if (!settings || !lineCfg || !reqCfg) {
+    std::perror("gpiod config");
+    return false;
+  }
+
+  gpiod_line_settings_set_direction(settings, _mode[pin] == HAL_OUTPUT ?
+                                    GPIOD_LINE_DIRECTION_OUTPUT : GPIOD_LINE_DIRECTION_INPUT);
+  gpiod_line_settings_set_bias(settings, _pull[pin] == HAL_PULL_UP ? GPIOD_LINE_BIAS_PULL_UP :
+                               _pull[pin] == HAL_PULL_DOWN ? GPIOD_LINE_BIAS_PULL_DOWN :
+                               GPIOD_LINE_BIAS_DISABLED);
+  if (_edge[pin]) gpiod_line_settings_set_edge_detection(settings, GPIOD_LINE_EDGE_RISING);
+  gpiod_line_config_add_line_settings(lineCfg, &pin, 1, settings);
+  gpiod_request_config_set_consumer(reqCfg, "mppcInterface");
+
+  _lines[pin] = gpiod_chip_request_lines(_chip, reqCfg, lineCfg);
+
+  gpiod_request_config_free(reqCfg);
+  gpiod_line_config_free(lineCfg);
+  gpiod_line_settings_free(settings);
+
+  if (!_lines[pin]) {
+    std::fprintf(stderr, "gpiod request of GPIO%u: %s\n", pin, strerror(errno));
+    return false;
+  }
+  return true;
+}
+
+void ChardevHal::pinMode(unsigned pin, HalPinMode mode) {
+  if (pin >= HAL_MAX_PINS) return;
+  _mode[pin] = mode;
+  request(pin);
+}
+
+void ChardevHal::pullUpDn(unsigned pin, HalPull pull) {
+  if (pin >= HAL_MAX_PINS) return;
+  _pull[pin] = pull;
+  if (_lines[pin]) request(pin);
+}
+
+void ChardevHal::digitalWrite(unsigned pin, int level) {
+  if (pin >= HAL_MAX_PINS || !_lines[pin]) return;
+  gpiod_line_request_set_value(_lines[pin], pin, level ? GPIOD_LINE_VALUE_ACTIVE : GPIOD_LINE_VALUE_INACTIVE);
+}
+
+int ChardevHal::digitalRead(unsigned pin) {
+  if (pin >= HAL_MAX_PINS || (!_lines[pin] && !request(pin))) return 0;
+  return gpiod_line_request_get_value(_lines[pin], pin) == GPIOD_LINE_VALUE_ACTIVE;
+}
+
+void ChardevHal::delayUs(uint32_t us) {
+  struct timespec ts;
+  if (us >= 100) {
+    ts.tv_sec  = us / 1000000;
+    ts.tv_nsec = (us % 1000000) * 1000L;
+    while (nanosleep(&ts, &ts) < 0 && errno == EINTR) {}
+    return;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  uint64_t end = (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec + us * 1000ULL;
+  do {
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+  } while ((uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec < end);
+}
+
+bool ChardevHal::spiSetup(uint8_t channel, uint32_t speed_hz, uint8_t mode) {
+  if (channel >= HAL_SPI_CHANNELS) return false;
+  char device[32];
+  std::snprintf(device, sizeof(device), "/dev/spidev0.%u", channel);
+  int fd = open(device, O_RDWR | O_CLOEXEC);
+  if (fd < 0) {
+    std::perror(device);
+    return false;
+  }
+  uint8_t bits = 8;
+  if (ioctl(fd, SPI_IOC_WR_MODE, &mode) < 0 ||
+      ioctl(fd, SPI_IOC_WR_BITS_PER_WORD, &bits) < 0 ||
+      ioctl(fd, SPI_IOC_WR_MAX_SPEED_HZ, &speed_hz) < 0) {
+    std::perror("spidev setup");
+    close(fd);
+    return false;
+  }
+  if (_spiFd[channel] >= 0) close(_spiFd[channel]);
+  _spiFd[channel]    = fd;
+  _spiSpeed[channel] = speed_hz;
+  return true;
+}
+
+int ChardevHal::spiTransfer(uint8_t channel, uint8_t *data, size_t len) {
+  if (channel >= HAL_SPI_CHANNELS || _spiFd[channel] < 0) return -1;
+  struct spi_ioc_transfer xfer;
+  std::memset(&xfer, 0, sizeof(xfer));
+  xfer.tx_buf        = (unsigned long)data;
+  xfer.rx_buf        = (unsigned long)data;
+  xfer.len           = len;
+  xfer.speed_hz      = _spiSpeed[channel];
+  xfer.bits_per_word = 8;
+  return ioctl(_spiFd[channel], SPI_IOC_MESSAGE(1), &xfer) < 0 ? -1 : (int)len;
+}
+
+int ChardevHal::i2cOpen(uint8_t bus, uint8_t address) {
+  char device[32];
+  std::snprintf(device, sizeof(device), "/dev/i2c-%u", bus);
+  int fd = open(device, O_RDWR | O_CLOEXEC);
+  if (fd < 0) {
+    std::perror(device);
+    return -1;
+  }
+  if (ioctl(fd, I2C_SLAVE, address) < 0) {
+    std::perror("I2C_SLAVE");
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+int ChardevHal::i2cWrite(int handle, const uint8_t *data, size_t len) {
+  return (int)write(handle, data, len);
+}
+
+int ChardevHal::i2cRead(int handle, uint8_t *data, size_t len) {
+  return (int)read(handle, data, len);
+}
+
+bool ChardevHal::onRisingEdge(unsigned pin, void (*handler)(void)) {
+  if (pin >= HAL_MAX_PINS) return false;
+  _mode[pin] = HAL_INPUT;
+  _edge[pin] = true;
+  if (!request(pin)) return false;
+  std::thread(&ChardevHal::edgeThread, this, pin, handler).detach();
+  return true;
+}
+
+void ChardevHal::edgeThread(unsigned pin, void (*handler)(void)) {
+  struct gpiod_edge_event_buffer *buffer = gpiod_edge_event_buffer_new(64);
+  if (!buffer) return;
+  while (1) {
+    int n = gpiod_line_request_read_edge_events(_lines[pin], buffer, 64);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      std::perror("gpiod_line_request_read_edge_events");
+      break;
+    }
+    for (int i = 0; i < n; i++) handler();
+  }
+  gpiod_edge_event_buffer_free(buffer);
+}
@@ -0,0 +1,56 @@
+// Linux character device backend: libgpiod v2 on /dev/gpiochip0, spidev
+// and i2c-dev. Needs no wiringPi and no root beyond the device permissions.
+//
+// Each pin gets its own line request the first time pinMode() is called;
+// reads and writes go through it. Rising-edge handlers run on one thread per
+// pin, like wiringPi's ISR threads.
+#ifndef __CHARDEVHAL_H__
+#define __CHARDEVHAL_H__
+
+#include <thread>
+
+#include "halBase.h"
+
+struct gpiod_chip;
+struct gpiod_line_request;
+
+#define HAL_SPI_CHANNELS 2
+
+class ChardevHal : public HalBase<ChardevHal> {
+ public:
+  ChardevHal();
+  ~ChardevHal();
+
+  bool setup();
+
+  void pinMode(unsigned pin, HalPinMode mode);
+  void pullUpDn(unsigned pin, HalPull pull);
+  void digitalWrite(unsigned pin, int level);
+  int digitalRead(unsigned pin);
+  void delayUs(uint32_t us);
+
+  bool spiSetup(uint8_t channel, uint32_t speed_hz, uint8_t mode);
+  int spiTransfer(uint8_t channel, uint8_t *data, size_t len);
+
+  int i2cOpen(uint8_t bus, uint8_t address);
+  int i2cWrite(int handle, const uint8_t *data, size_t len);
+  int i2cRead(int handle, uint8_t *data, size_t len);
+
+  bool onRisingEdge(unsigned pin, void (*handler)(void));
+
+ private:
+
+  bool request(unsigned pin);
+  void edgeThread(unsigned pin, void (*handler)(void));
+
+  struct gpiod_chip *_chip;
+  struct gpiod_line_request *_lines[HAL_MAX_PINS];
+  HalPinMode _mode[HAL_MAX_PINS];
+  HalPull _pull[HAL_MAX_PINS];
+  bool _edge[HAL_MAX_PINS];
+
+  int _spiFd[HAL_SPI_CHANNELS];
+  uint32_t _spiSpeed[HAL_SPI_CHANNELS];
+};
+
+#endif //__CHARDEVHAL_H__
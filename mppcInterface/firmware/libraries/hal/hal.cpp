@@ -0,0 +1,9 @@
+// hal.cpp — the process-wide backend instance
+// Build: g++ -O2 -std=c++11 [-DHAL_BACKEND_SIM | -DHAL_BACKEND_CHARDEV] -c hal.cpp
+
+#include "hal.h"
+
+Hal &hal() {
+  static Hal instance;
+  return instance;
+}
@@ -0,0 +1,24 @@
+// Hardware access for the mppcInterface tools, backend picked at build time.
+//
+//   make HAL=wiringpi   wiringPi (default, needs a Pi)
+//   make HAL=chardev    /dev/gpiochip0, /dev/spidevB.C, /dev/i2c-N
+//   make HAL=sim        in-process simulator, runs anywhere
+//
+// Code uses the Hal type and hal(), the one instance per process.
+#ifndef __HAL_H__
+#define __HAL_H__
+
+#if defined(HAL_BACKEND_SIM)
+#include "simHal.h"
+typedef SimHal Hal;
+#elif defined(HAL_BACKEND_CHARDEV)
+#include "chardevHal.h"
+typedef ChardevHal Hal;
+#else
+#include "wiringPiHal.h"
+typedef WiringPiHal Hal;
+#endif
+
+Hal &hal();
+
+#endif //__HAL_H__
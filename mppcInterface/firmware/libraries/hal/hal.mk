@@ -0,0 +1,28 @@
+# Shared by every tool that talks to hardware through hal.h.
+#
+#   include ../hal/hal.mk
+#   OBJECTS += $(HAL_OBJECTS)
+#   LDLIBS   = $(HAL_LDLIBS) ...
+#
+# make HAL=chardev or make HAL=sim picks the backend, wiringPi by default.
+
+HAL ?= wiringpi
+HALDIR := $(dir $(lastword $(MAKEFILE_LIST)))
+
+CXXFLAGS += -I$(HALDIR)
+vpath %.cpp $(HALDIR)
+
+ifeq ($(HAL),sim)
+CXXFLAGS += -DHAL_BACKEND_SIM
+HAL_OBJECTS = hal.o simHal.o
+HAL_LDLIBS = -lpthread
+else ifeq ($(HAL),chardev)
+CXXFLAGS += -DHAL_BACKEND_CHARDEV
+HAL_OBJECTS = hal.o chardevHal.o
+HAL_LDLIBS = -lgpiod -lpthread
+else
+HAL_OBJECTS = hal.o
+HAL_LDLIBS = -lwiringPi
+endif
+
+HAL_HEADERS = $(addprefix $(HALDIR),hal.h halBase.h simHal.h chardevHal.h wiringPiHal.h)
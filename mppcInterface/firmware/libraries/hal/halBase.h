@@ -0,0 +1,69 @@
+// Common part of every GPIO/SPI/I2C backend.
+//
+// Backends derive from HalBase<Backend> (CRTP) and provide the primitives
+// below as ordinary, non-virtual members. The helpers here are written
+// against those primitives and resolve to the backend at compile time, so
+// nothing on a hot path goes through a vtable.
+//
+//   bool setup();
+//   void pinMode(unsigned pin, HalPinMode mode);
+//   void pullUpDn(unsigned pin, HalPull pull);
+//   void digitalWrite(unsigned pin, int level);
+//   int  digitalRead(unsigned pin);
+//   void delayUs(uint32_t us);
+//   bool spiSetup(uint8_t channel, uint32_t speed_hz, uint8_t mode);
+//   int  spiTransfer(uint8_t channel, uint8_t *data, size_t len);   // in place
+//   int  i2cOpen(uint8_t bus, uint8_t address);                      // handle
+//   int  i2cWrite(int handle, const uint8_t *data, size_t len);
+//   int  i2cRead(int handle, uint8_t *data, size_t len);
+//   bool onRisingEdge(unsigned pin, void (*handler)(void));
+//
+// Pins are BCM GPIO numbers on every backend. Transfers return the byte
+// count or -1 with errno set.
+#ifndef __HALBASE_H__
+#define __HALBASE_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define HAL_MAX_PINS 54
+
+enum HalPinMode { HAL_INPUT = 0, HAL_OUTPUT = 1 };
+enum HalPull { HAL_PULL_OFF = 0, HAL_PULL_DOWN = 1, HAL_PULL_UP = 2 };
+
+template <class Backend>
+class HalBase {
+ public:
+
+  // Poll pin every millisecond until it reads level, false on timeout
+  bool waitFor(unsigned pin, int level, uint32_t timeoutMs) {
+    while (self().digitalRead(pin) != level) {
+      if (timeoutMs-- == 0) return false;
+      self().delayUs(1000);
+    }
+    return true;
+  }
+
+  // Drive pin to level for us, then back
+  inline void pulse(unsigned pin, int level, uint32_t us) {
+    self().digitalWrite(pin, level);
+    self().delayUs(us);
+    self().digitalWrite(pin, !level);
+  }
+
+  // Long transfers in pieces the driver accepts, stops at the first error
+  int spiTransferChunked(uint8_t channel, uint8_t *data, size_t len, size_t chunk) {
+    size_t done = 0;
+    while (done < len) {
+      size_t n = len - done < chunk ? len - done : chunk;
+      if (self().spiTransfer(channel, data + done, n) < 0) return -1;
+      done += n;
+    }
+    return (int)done;
+  }
+
+ private:
+  inline Backend &self() { return *static_cast<Backend *>(this); }
+};
+
+#endif //__HALBASE_H__
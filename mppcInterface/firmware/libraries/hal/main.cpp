@@ -0,0 +1,81 @@
+// main.cpp — per-call cost of the HAL primitives on the backend built in
+// - digitalWrite/digitalRead on one pin, spiTransfer of a few sizes
+// - Same loop for every backend, so wiringPi and chardev can be compared
+//   on a Pi and the simulator anywhere
+// Build: make [HAL=wiringpi|chardev|sim]
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <unistd.h>
+
+#include "hal.h"
+
+static double nowSec() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void usage(const char *name) {
+  std::fprintf(stderr, "Usage: %s [-n calls] [-o out_pin] [-i in_pin] [-s spi_channel]\n", name);
+}
+
+int main(int argc, char **argv) {
+  uint32_t calls  = 1000000;
+  unsigned outPin = 24;   // ICE40 CS, idle high
+  unsigned inPin  = 23;   // ICE40 DONE
+  int spiChannel  = 0;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "n:o:i:s:h")) != -1) {
+    switch (opt) {
+      case 'n': calls      = strtoul(optarg, NULL, 10); break;
+      case 'o': outPin     = atoi(optarg); break;
+      case 'i': inPin      = atoi(optarg); break;
+      case 's': spiChannel = atoi(optarg); break;
+      default:  usage(argv[0]); return 1;
+    }
+  }
+
+  Hal &io = hal();
+  if (!io.setup()) {
+    std::fprintf(stderr, "HAL setup failed\n");
+    return 1;
+  }
+  io.pinMode(outPin, HAL_OUTPUT);
+  io.pinMode(inPin, HAL_INPUT);
+  io.pullUpDn(inPin, HAL_PULL_UP);
+
+  double t0 = nowSec();
+  for (uint32_t i = 0; i < calls; i++) io.digitalWrite(outPin, i & 1);
+  double t1 = nowSec();
+  int ones = 0;
+  for (uint32_t i = 0; i < calls; i++) ones += io.digitalRead(inPin);
+  double t2 = nowSec();
+  io.digitalWrite(outPin, 1);
+
+  std::printf("digitalWrite %8.1f ns/call\n", (t1 - t0) * 1e9 / calls);
+  std::printf("digitalRead  %8.1f ns/call (%d high)\n", (t2 - t1) * 1e9 / calls, ones);
+
+  if (!io.spiSetup(spiChannel, 4000000, 0)) {
+    std::perror("spiSetup");
+    return 0;
+  }
+  static uint8_t buffer[4096];
+  const size_t sizes[] = {1, 16, 256, 4096};
+  for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+    uint32_t n = calls / 100 / (uint32_t)(s + 1) + 1;
+    double start = nowSec();
+    for (uint32_t i = 0; i < n; i++) {
+      if (io.spiTransfer(spiChannel, buffer, sizes[s]) < 0) {
+        std::perror("spiTransfer");
+        return 1;
+      }
+    }
+    double sec = nowSec() - start;
+    std::printf("spiTransfer %4zu B %8.1f us/call %8.2f MB/s\n",
+                sizes[s], sec * 1e6 / n, n * sizes[s] / sec / 1e6);
+  }
+  return 0;
+}
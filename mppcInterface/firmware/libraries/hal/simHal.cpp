@@ -0,0 +1,156 @@
+// simHal.cpp — scripted, virtual-time implementation of the HAL
+// - Input scripts are kept sorted, a read takes the last step at or before now
+// - Queued SPI responses are used before an attached device callback
+// - Edge generators run on real time, everything else on virtual time
+// Build: g++ -O2 -std=c++11 -DHAL_BACKEND_SIM -c simHal.cpp (link -lpthread)
+
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <random>
+#include <thread>
+
+#include "simHal.h"
+
+SimHal::SimHal() {
+  _now_us = 0;
+  for (int i = 0; i < HAL_MAX_PINS; i++) {
+    _mode[i]     = HAL_INPUT;
+    _pull[i]     = HAL_PULL_OFF;
+    _out[i]      = 0;
+    _handlers[i] = NULL;
+  }
+  for (int i = 0; i < HAL_SPI_CHANNELS; i++) {
+    _spiSpeed[i]  = 0;
+    _spiMode[i]   = 0;
+    _spiDevice[i] = NULL;
+    _spiCtx[i]    = NULL;
+  }
+  _nI2c = 0;
+}
+
+bool SimHal::setup() {
+  return true;
+}
+
+int SimHal::digitalRead(unsigned pin) {
+  if (pin >= HAL_MAX_PINS) return 0;
+  if (_mode[pin] == HAL_OUTPUT) return _out[pin];
+  const std::vector<Step> &script = _script[pin];
+  for (size_t i = script.size(); i-- > 0;)
+    if (script[i].at_us <= _now_us) return script[i].level;
+  return _pull[pin] == HAL_PULL_UP;
+}
+
+void SimHal::scriptInput(unsigned pin, int level, uint64_t at_us) {
+  if (pin >= HAL_MAX_PINS) return;
+  std::vector<Step> &script = _script[pin];
+  Step step = {at_us, level ? 1 : 0};
+  size_t i = script.size();
+  while (i > 0 && script[i - 1].at_us > at_us) i--;
+  script.insert(script.begin() + i, step);
+}
+
+bool SimHal::spiSetup(uint8_t channel, uint32_t speed_hz, uint8_t mode) {
+  if (channel >= HAL_SPI_CHANNELS || speed_hz == 0) return false;
+  _spiSpeed[channel] = speed_hz;
+  _spiMode[channel]  = mode;
+  return true;
+}
+
+int SimHal::spiTransfer(uint8_t channel, uint8_t *data, size_t len) {
+  if (channel >= HAL_SPI_CHANNELS || _spiSpeed[channel] == 0) {
+    errno = ENODEV;
+    return -1;
+  }
+  _spiWritten[channel].insert(_spiWritten[channel].end(), data, data + len);
+  _now_us += (len * 8 * 1000000ULL + _spiSpeed[channel] - 1) / _spiSpeed[channel];
+
+  std::deque<uint8_t> &responses = _spiResponses[channel];
+  size_t i = 0;
+  for (; i < len && !responses.empty(); i++) {
+    data[i] = responses.front();
+    responses.pop_front();
+  }
+  if (i < len) {
+    if (_spiDevice[channel]) _spiDevice[channel](channel, data + i, len - i, _spiCtx[channel]);
+    else std::memset(data + i, 0, len - i);
+  }
+  return (int)len;
+}
+
+void SimHal::spiRespond(uint8_t channel, const uint8_t *data, size_t len) {
+  if (channel < HAL_SPI_CHANNELS) _spiResponses[channel].insert(_spiResponses[channel].end(), data, data + len);
+}
+
+void SimHal::spiAttach(uint8_t channel, SpiDevice device, void *ctx) {
+  if (channel >= HAL_SPI_CHANNELS) return;
+  _spiDevice[channel] = device;
+  _spiCtx[channel]    = ctx;
+}
+
+int SimHal::i2cOpen(uint8_t bus, uint8_t address) {
+  for (int i = 0; i < _nI2c; i++)
+    if (_i2c[i].bus == bus && _i2c[i].address == address) return i;
+  if (_nI2c == SIMHAL_I2C_DEVICES) {
+    errno = ENOMEM;
+    return -1;
+  }
+  _i2c[_nI2c].bus     = bus;
+  _i2c[_nI2c].address = address;
+  return _nI2c++;
+}
+
+int SimHal::i2cWrite(int handle, const uint8_t *data, size_t len) {
+  if (handle < 0 || handle >= _nI2c) return -1;
+  _i2c[handle].written.insert(_i2c[handle].written.end(), data, data + len);
+  return (int)len;
+}
+
+int SimHal::i2cRead(int handle, uint8_t *data, size_t len) {
+  if (handle < 0 || handle >= _nI2c) return -1;
+  std::deque<uint8_t> &responses = _i2c[handle].responses;
+  for (size_t i = 0; i < len; i++) {
+    data[i] = responses.empty() ? 0xFF : responses.front();   // idle bus reads high
+    if (!responses.empty()) responses.pop_front();
+  }
+  return (int)len;
+}
+
+void SimHal::i2cRespond(uint8_t bus, uint8_t address, const uint8_t *data, size_t len) {
+  int handle = i2cOpen(bus, address);
+  if (handle >= 0) _i2c[handle].responses.insert(_i2c[handle].responses.end(), data, data + len);
+}
+
+bool SimHal::onRisingEdge(unsigned pin, void (*handler)(void)) {
+  if (pin >= HAL_MAX_PINS) return false;
+  _handlers[pin] = handler;
+  const char *rate = getenv("SIMHAL_EDGE_HZ");
+  if (rate && atof(rate) > 0) std::thread(&SimHal::generator, handler, atof(rate), pin).detach();
+  return true;
+}
+
+void SimHal::inject(unsigned pin, uint32_t edges) {
+  if (pin >= HAL_MAX_PINS || !_handlers[pin]) return;
+  for (uint32_t i = 0; i < edges; i++) _handlers[pin]();
+}
+
+// Poisson edges in real time, for running whole tools against the simulator
+void SimHal::generator(void (*handler)(void), double rate_hz, unsigned seed) {
+  std::mt19937_64 rng(seed + 1);
+  std::exponential_distribution<double> gap(rate_hz);
+  std::chrono::steady_clock::time_point next = std::chrono::steady_clock::now();
+  while (1) {
+    next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(gap(rng)));
+    std::this_thread::sleep_until(next);
+    handler();
+  }
+}
+
+void SimHal::clearLogs() {
+  _writes.clear();
+  for (int i = 0; i < HAL_SPI_CHANNELS; i++) _spiWritten[i].clear();
+  for (int i = 0; i < _nI2c; i++) _i2c[i].written.clear();
+}
@@ -0,0 +1,104 @@
+// In-process simulator backend. Runs anywhere, no hardware, no root.
+//
+// Time is virtual: delayUs() and SPI transfers (at the configured clock)
+// advance now_us() instead of sleeping, so a flash or a bias ramp is
+// simulated in microseconds. Inputs follow a script of (time, level) steps,
+// or their pull when nothing is scripted. SPI and I2C writes are logged;
+// reads come from queued responses or from a device callback. Rising-edge
+// handlers fire on inject(), or from a Poisson generator per pin when
+// SIMHAL_EDGE_HZ is set in the environment.
+#ifndef __SIMHAL_H__
+#define __SIMHAL_H__
+
+#include <vector>
+#include <deque>
+
+#include "halBase.h"
+
+#define HAL_SPI_CHANNELS 2
+#define SIMHAL_I2C_DEVICES 8
+
+class SimHal : public HalBase<SimHal> {
+ public:
+  // Scripted SPI device: sees the bytes written, fills in the bytes read
+  typedef void (*SpiDevice)(uint8_t channel, uint8_t *data, size_t len, void *ctx);
+
+  struct Write {
+    uint64_t time_us;
+    unsigned pin;
+    int level;
+  };
+
+  SimHal();
+
+  bool setup();
+
+  inline void pinMode(unsigned pin, HalPinMode mode) { if (pin < HAL_MAX_PINS) _mode[pin] = mode; }
+  inline void pullUpDn(unsigned pin, HalPull pull) { if (pin < HAL_MAX_PINS) _pull[pin] = pull; }
+  inline void digitalWrite(unsigned pin, int level) {
+    if (pin >= HAL_MAX_PINS) return;
+    _out[pin] = level ? 1 : 0;
+    _writes.push_back(Write{_now_us, pin, _out[pin]});
+  }
+  int digitalRead(unsigned pin);
+  inline void delayUs(uint32_t us) { _now_us += us; }
+
+  bool spiSetup(uint8_t channel, uint32_t speed_hz, uint8_t mode);
+  int spiTransfer(uint8_t channel, uint8_t *data, size_t len);
+
+  int i2cOpen(uint8_t bus, uint8_t address);
+  int i2cWrite(int handle, const uint8_t *data, size_t len);
+  int i2cRead(int handle, uint8_t *data, size_t len);
+
+  bool onRisingEdge(unsigned pin, void (*handler)(void));
+
+  // Scripting and inspection
+  uint64_t now_us() const { return _now_us; }
+  void scriptInput(unsigned pin, int level, uint64_t at_us);
+  void inject(unsigned pin, uint32_t edges = 1);
+  void spiRespond(uint8_t channel, const uint8_t *data, size_t len);
+  void spiAttach(uint8_t channel, SpiDevice device, void *ctx);
+  void i2cRespond(uint8_t bus, uint8_t address, const uint8_t *data, size_t len);
+
+  const std::vector<Write> &writes() const { return _writes; }
+  const std::vector<uint8_t> &spiWritten(uint8_t channel) const { return _spiWritten[channel]; }
+  const std::vector<uint8_t> &i2cWritten(int handle) const { return _i2c[handle].written; }
+  uint8_t spiMode(uint8_t channel) const { return _spiMode[channel]; }
+  void clearLogs();
+
+ private:
+
+  struct Step {
+    uint64_t at_us;
+    int level;
+  };
+
+  struct I2cDevice {
+    uint8_t bus;
+    uint8_t address;
+    std::vector<uint8_t> written;
+    std::deque<uint8_t> responses;
+  };
+
+  static void generator(void (*handler)(void), double rate_hz, unsigned seed);
+
+  uint64_t _now_us;
+  HalPinMode _mode[HAL_MAX_PINS];
+  HalPull _pull[HAL_MAX_PINS];
+  int _out[HAL_MAX_PINS];
+  std::vector<Step> _script[HAL_MAX_PINS];
+  void (*_handlers[HAL_MAX_PINS])(void);
+  std::vector<Write> _writes;
+
+  uint32_t _spiSpeed[HAL_SPI_CHANNELS];
+  uint8_t _spiMode[HAL_SPI_CHANNELS];
+  std::vector<uint8_t> _spiWritten[HAL_SPI_CHANNELS];
+  std::deque<uint8_t> _spiResponses[HAL_SPI_CHANNELS];
+  SpiDevice _spiDevice[HAL_SPI_CHANNELS];
+  void *_spiCtx[HAL_SPI_CHANNELS];
+
+  I2cDevice _i2c[SIMHAL_I2C_DEVICES];
+  int _nI2c;
+};
+
+#endif //__SIMHAL_H__
@@ -0,0 +1,70 @@
+// wiringPi backend, BCM pin numbers (wiringPiSetupGpio).
+// Everything is inline so calls compile straight to the wiringPi functions.
+#ifndef __WIRINGPIHAL_H__
+#define __WIRINGPIHAL_H__
+
+#include <stdio.h>
+#include <unistd.h>
+#include <wiringPi.h>
+#include <wiringPiSPI.h>
+#include <wiringPiI2C.h>
+
+#include "halBase.h"
+
+#define HAL_SPI_CHANNELS 2   // spidev0.0, spidev0.1
+
+class WiringPiHal : public HalBase<WiringPiHal> {
+ public:
+  WiringPiHal() {
+    for (int i = 0; i < HAL_SPI_CHANNELS; i++) {
+      _spiSpeed[i] = 0;
+      _spiMode[i]  = 0;
+    }
+  }
+
+  bool setup() { return wiringPiSetupGpio() == 0; }
+
+  inline void pinMode(unsigned pin, HalPinMode mode) { ::pinMode(pin, mode == HAL_OUTPUT ? OUTPUT : INPUT); }
+  inline void pullUpDn(unsigned pin, HalPull pull) {
+    pullUpDnControl(pin, pull == HAL_PULL_UP ? PUD_UP : pull == HAL_PULL_DOWN ? PUD_DOWN : PUD_OFF);
+  }
+  inline void digitalWrite(unsigned pin, int level) { ::digitalWrite(pin, level ? HIGH : LOW); }
+  inline int digitalRead(unsigned pin) { return ::digitalRead(pin); }
+  inline void delayUs(uint32_t us) { delayMicroseconds(us); }
+
+  // wiringPiSPISetupMode opens the spidev again on every call, and every
+  // FPGA driver sets up channel 0, so a repeat is a no-op and a change
+  // closes the old fd first
+  bool spiSetup(uint8_t channel, uint32_t speed_hz, uint8_t mode) {
+    if (channel >= HAL_SPI_CHANNELS) return false;
+    if (_spiSpeed[channel] == speed_hz && _spiMode[channel] == mode) return true;
+    if (_spiSpeed[channel]) ::close(wiringPiSPIGetFd(channel));
+    _spiSpeed[channel] = 0;
+    if (wiringPiSPISetupMode(channel, speed_hz, mode) < 0) return false;
+    _spiSpeed[channel] = speed_hz;
+    _spiMode[channel]  = mode;
+    return true;
+  }
+  inline int spiTransfer(uint8_t channel, uint8_t *data, size_t len) {
+    return wiringPiSPIDataRW(channel, data, (int)len) < 0 ? -1 : (int)len;
+  }
+
+  int i2cOpen(uint8_t bus, uint8_t address) {
+    char device[32];
+    snprintf(device, sizeof(device), "/dev/i2c-%u", bus);
+    return wiringPiI2CSetupInterface(device, address);
+  }
+  inline int i2cWrite(int handle, const uint8_t *data, size_t len) { return (int)::write(handle, data, len); }
+  inline int i2cRead(int handle, uint8_t *data, size_t len) { return (int)::read(handle, data, len); }
+
+  bool onRisingEdge(unsigned pin, void (*handler)(void)) {
+    return wiringPiISR(pin, INT_EDGE_RISING, handler) >= 0;
+  }
+
+ private:
+
+  uint32_t _spiSpeed[HAL_SPI_CHANNELS];   // 0 until set up
+  uint8_t _spiMode[HAL_SPI_CHANNELS];
+};
+
+#endif //__WIRINGPIHAL_H__
@@ -2,7 +2,7 @@
 // - SPI MODE 0
 // - Reads full .bin (no hard-coded size)
 // - Streams in chunks
-// Build: g++ -O2 -std=c++11 -Wall -lwiringPi -lwiringPiDev -c ice40.cpp
+// Build: g++ -O2 -std=c++11 -Wall -I../hal -c ice40.cpp (see ../hal/hal.mk)
 
 #include <cstdio>
 #include <cstdlib>
@@ -11,12 +11,9 @@
 #include <fstream>
 #include <algorithm>
 
-#include <wiringPi.h>
-#include <wiringPiSPI.h>
-
 #include "ice40.h"
 
-ICE40::ICE40(const uint8_t CS_PIN, const uint8_t DONE_PIN, const uint8_t RST_PIN, const uint8_t SPI_CHANNEL) {
+ICE40::ICE40(const uint8_t CS_PIN, const uint8_t DONE_PIN, const uint8_t RST_PIN, const uint8_t SPI_CHANNEL) : _hal(hal()) {
   _CS_PIN      = CS_PIN;
   _DONE_PIN    = DONE_PIN;
   _RST_PIN     = RST_PIN;
@@ -26,24 +23,24 @@ ICE40::ICE40(const uint8_t CS_PIN, const uint8_t DONE_PIN, const uint8_t RST_PIN
 }
 
 void ICE40::setup(const uint8_t SPI_CHANNEL, const uint32_t clkSpeed) {
-  wiringPiSetup();
+  _hal.setup();
 
   // Keep your original GPCLK: WiringPi pin 7 (BCM4) @ 9.6 MHz
   //pinMode(7, GPIO_CLOCK);
   //gpioClockSet(7, 9600000);
 
   // iCE40 expects SPI mode 0
-  if (wiringPiSPISetupMode(SPI_CHANNEL, clkSpeed, 0) < 0) {
-    std::perror("wiringPiSPISetupMode");
+  if (!_hal.spiSetup(SPI_CHANNEL, clkSpeed, 0)) {
+    std::perror("spiSetup");
   }
 
-  pinMode(_CS_PIN,   OUTPUT);
-  pinMode(_RST_PIN,  OUTPUT);
-  pinMode(_DONE_PIN, INPUT);
-  pullUpDnControl(_DONE_PIN, PUD_UP);
+  _hal.pinMode(_CS_PIN,   HAL_OUTPUT);
+  _hal.pinMode(_RST_PIN,  HAL_OUTPUT);
+  _hal.pinMode(_DONE_PIN, HAL_INPUT);
+  _hal.pullUpDn(_DONE_PIN, HAL_PULL_UP);
 
-  digitalWrite(_CS_PIN,  HIGH);
-  digitalWrite(_RST_PIN, HIGH);
+  _hal.digitalWrite(_CS_PIN,  1);
+  _hal.digitalWrite(_RST_PIN, 1);
 }
 
 void ICE40::configure(const char filename[]) {
@@ -79,35 +76,32 @@ void ICE40::burnData(unsigned char* data, uint16_t length) {
 
   // 8 dummy clocks with CS high
   unsigned char dmy[8] = {0};
-  wiringPiSPIDataRW(_SPI_CHANNEL, dmy, sizeof(dmy));
+  _hal.spiTransfer(_SPI_CHANNEL, dmy, sizeof(dmy));
 
   // Hold our dedicated CS low during streaming
-  digitalWrite(_CS_PIN, LOW);
+  _hal.digitalWrite(_CS_PIN, 0);
 
   // Stream the bitstream in chunks
   const int CHUNK = 4096;
   uint16_t sent = 0;
   while (sent < length) {
     int n = std::min<int>(CHUNK, static_cast<int>(length - sent));
-    if (wiringPiSPIDataRW(_SPI_CHANNEL, data + sent, n) < 0) {
-      std::perror("wiringPiSPIDataRW");
+    if (_hal.spiTransfer(_SPI_CHANNEL, data + sent, n) < 0) {
+      std::perror("spiTransfer");
       break;
     }
     sent += static_cast<uint16_t>(n);
   }
 
   // Deassert CS
-  digitalWrite(_CS_PIN, HIGH);
+  _hal.digitalWrite(_CS_PIN, 1);
 
   // Extra clocks to flush
   unsigned char tail[16] = {0};
-  wiringPiSPIDataRW(_SPI_CHANNEL, tail, sizeof(tail));
+  _hal.spiTransfer(_SPI_CHANNEL, tail, sizeof(tail));
 
   // Wait for DONE to go high (up to ~1 s)
-  unsigned int guard_ms = 1000;
-  while (!digitalRead(_DONE_PIN) && guard_ms--) delay(1);
-
-  if (!digitalRead(_DONE_PIN)) {
+  if (!_hal.waitFor(_DONE_PIN, 1, 1000)) {
     std::fprintf(stderr, "ERROR: DONE pin did not go high. Configuration may have failed.\n");
   } else {
     std::printf("DONE=1 (configuration successful)\n");
@@ -115,10 +109,8 @@ void ICE40::burnData(unsigned char* data, uint16_t length) {
 }
 
 void ICE40::clear() {
-  digitalWrite(_CS_PIN,  LOW);
-  digitalWrite(_RST_PIN, LOW);
-  delayMicroseconds(200);
-  digitalWrite(_RST_PIN, HIGH);
-  delayMicroseconds(1200);
-  digitalWrite(_CS_PIN,  HIGH);
+  _hal.digitalWrite(_CS_PIN,  0);
+  _hal.pulse(_RST_PIN, 0, 200);
+  _hal.delayUs(1200);
+  _hal.digitalWrite(_CS_PIN,  1);
 }
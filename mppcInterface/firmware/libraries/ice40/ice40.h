@@ -1,9 +1,13 @@
-// Wiring Pi library for configuing the ICE40 FPGA with a *.bin file.
+// Library for configuing the ICE40 FPGA with a *.bin file, through the HAL
+// (../hal) so it builds for wiringPi, the character devices or the simulator.
+// Pins are BCM numbers.
 #ifndef __ICE40_H__
 #define __ICE40_H__
 
 #include <stdint.h>
 
+#include "hal.h"
+
 class ICE40 {
  public:
   ICE40(const uint8_t CS_PIN, const uint8_t DONE_PIN, const uint8_t RST_PIN, const uint8_t SPI_CHANNEL);
@@ -16,6 +20,7 @@ class ICE40 {
   void burnData(unsigned char *data, uint16_t length);
   void clear();
 
+  Hal &_hal;
   uint8_t _CS_PIN;
   uint8_t _RST_PIN;
   uint8_t _DONE_PIN;
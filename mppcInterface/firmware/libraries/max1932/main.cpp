@@ -1,17 +1,15 @@
 #include <stdio.h>
 #include <stdlib.h>
-#include <wiringPi.h>
-#include <wiringPiSPI.h>
 
 #include "max1932.h"
 
 // Makefile needed
-// -lwiringPi
+// include ../hal/hal.mk, make HAL=wiringpi|chardev|sim
 
 // HV chip select GPIO13, Header Pin 33, Wiring pi Pin 23
 // SPI Channel 0
 
-#define CS_PIN 23
+#define CS_PIN 13
 #define SPI_CHANNEL 0
 
 // Argv 1 Bit value to set for voltage
@@ -1,17 +1,15 @@
 #include <stdio.h>
 #include <stdlib.h>
-#include <wiringPi.h>
-#include <wiringPiSPI.h>
 
 #include "max1932.h"
 
-MAX1932::MAX1932(){}
+MAX1932::MAX1932() : _hal(hal()) {}
 
-MAX1932::MAX1932(uint8_t CS_PIN, uint8_t SPI_CHANNEL){
+MAX1932::MAX1932(uint8_t CS_PIN, uint8_t SPI_CHANNEL) : _hal(hal()) {
   setup(CS_PIN, SPI_CHANNEL);
 }
 //DIV_TOP R5, DIV_BOTTOM R8, DAC_OUT R6
-MAX1932::MAX1932(uint8_t CS_PIN, uint8_t SPI_CHANNEL, uint32_t DIV_TOP, uint32_t DIV_BOT, uint32_t DAC_OUT){
+MAX1932::MAX1932(uint8_t CS_PIN, uint8_t SPI_CHANNEL, uint32_t DIV_TOP, uint32_t DIV_BOT, uint32_t DAC_OUT) : _hal(hal()) {
   _DIV_TOP = DIV_TOP;
   _DIV_BOT = DIV_BOT;
   _DAC_OUT = DAC_OUT;
@@ -62,17 +60,17 @@ void MAX1932::setup(uint8_t CS_PIN, uint8_t SPI_CHANNEL){
   _CS_PIN = CS_PIN;
   _SPI_CHANNEL = SPI_CHANNEL;
 
-  wiringPiSetup();
-  wiringPiSPISetupMode(_SPI_CHANNEL, 1000000, 0);
-  pinMode(_CS_PIN, OUTPUT);
-  digitalWrite(_CS_PIN,  HIGH);
-  delay(5);
+  _hal.setup();
+  _hal.spiSetup(_SPI_CHANNEL, 1000000, 0);
+  _hal.pinMode(_CS_PIN, HAL_OUTPUT);
+  _hal.digitalWrite(_CS_PIN,  1);
+  _hal.delayUs(5000);
 }
 
 void MAX1932::write(uint8_t val){
   uint8_t data[1] = {val};
-  digitalWrite(_CS_PIN, LOW);
-  wiringPiSPIDataRW(_SPI_CHANNEL, data, 1);
-  digitalWrite(_CS_PIN,  HIGH);
+  _hal.digitalWrite(_CS_PIN, 0);
+  _hal.spiTransfer(_SPI_CHANNEL, data, 1);
+  _hal.digitalWrite(_CS_PIN,  1);
 }
 
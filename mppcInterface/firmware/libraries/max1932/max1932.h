@@ -1,9 +1,12 @@
-//WiringPi library for interfacing with the MAX1932 APD Bias Supply
+//Library for interfacing with the MAX1932 APD Bias Supply, through the HAL (../hal)
+//Pins are BCM numbers
 #ifndef __MAX1932_H__
 #define __MAX1932_H__
 
 #include <stdint.h>
 
+#include "hal.h"
+
 class MAX1932 {
  public:
 
@@ -22,6 +25,7 @@ class MAX1932 {
   void setup(uint8_t CS_PIN, uint8_t SPI_CHANNEL);
   void write(uint8_t val);
 
+  Hal &_hal;
   uint8_t _CS_PIN;
   uint8_t _SPI_CHANNEL;
 
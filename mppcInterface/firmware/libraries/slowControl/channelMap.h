@@ -0,0 +1,98 @@
+// The counter inputs of slowControl, declared once.
+//
+// Every row is one Pi GPIO that the FPGA drives, in counters[] and log
+// column order, with the FPGA channels ANDed onto it (one bit = that raw
+// channel). Counter banks, log records, the count store, the live segment,
+// the edge handlers, the software coincidences and the FPGA loss check are
+// all sized and generated from this table, so wiring another board (up to
+// 8 inputs) means editing these rows and rebuilding, nothing else.
+//
+// Handlers are instantiated per row by templates (ChannelHandlers), so each
+// one is a fully specialised function with its counter slot and role fixed
+// at compile time.
+#ifndef __CHANNELMAP_H__
+#define __CHANNELMAP_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+struct ChannelSpec {
+  const char *name;     // log and report header
+  unsigned bcm;         // Pi GPIO (gpiochip0 line offset)
+  uint8_t fpgaMask;     // FPGA CHn ANDed onto the pin, bit n
+};
+
+constexpr ChannelSpec CHANNEL_MAP[] = {
+  {"CH0&&CH1",      27, 0x03},
+  {"CH0&&CH2",      18, 0x05},
+  {"CH1&&CH2",      17, 0x06},
+  {"CH0&&CH1&&CH2", 25, 0x07},
+  {"CH0",            6, 0x01},
+  {"CH1",            5, 0x02},
+  {"CH2",           16, 0x04},
+};
+
+#define CHANNEL_COUNT (sizeof(CHANNEL_MAP) / sizeof(CHANNEL_MAP[0]))
+#define CHANNEL_MAX 8
+
+static_assert(CHANNEL_COUNT >= 1 && CHANNEL_COUNT <= CHANNEL_MAX, "1 to 8 counter inputs");
+
+constexpr unsigned channelBits(uint8_t mask) {
+  return mask ? (mask & 1) + channelBits(mask >> 1) : 0;
+}
+
+// A raw input carries exactly one FPGA channel, a coincidence more
+constexpr bool channelIsRaw(size_t i) { return channelBits(CHANNEL_MAP[i].fpgaMask) == 1; }
+constexpr bool channelIsCoincidence(size_t i) { return channelBits(CHANNEL_MAP[i].fpgaMask) > 1; }
+
+// FPGA channel of a raw input
+constexpr uint8_t channelFpga(size_t i, uint8_t bit = 0) {
+  return bit >= 8 || CHANNEL_MAP[i].fpgaMask >> bit & 1 ? bit : channelFpga(i, bit + 1);
+}
+
+constexpr size_t countRaw(size_t i = 0) {
+  return i == CHANNEL_COUNT ? 0 : channelIsRaw(i) + countRaw(i + 1);
+}
+constexpr size_t countCoincidences(size_t i = 0) {
+  return i == CHANNEL_COUNT ? 0 : channelIsCoincidence(i) + countCoincidences(i + 1);
+}
+
+#define CHANNEL_RAW_COUNT countRaw()
+#define CHANNEL_COINC_COUNT countCoincidences()
+
+// 0 .. N-1 as a type, C++11 has no std::index_sequence
+template <size_t... I> struct ChannelIndices {};
+template <size_t N, size_t... I> struct MakeChannelIndices : MakeChannelIndices<N - 1, N - 1, I...> {};
+template <size_t... I> struct MakeChannelIndices<0, I...> { typedef ChannelIndices<I...> type; };
+
+// Handler<I> for every row: Handler<I>::edge() plain, Handler<I>::timed(ts)
+// with a timestamp. Tables are in counters[] order.
+template <template <size_t> class Handler, class Indices = typename MakeChannelIndices<CHANNEL_COUNT>::type>
+struct ChannelHandlers;
+
+template <template <size_t> class Handler, size_t... I>
+struct ChannelHandlers<Handler, ChannelIndices<I...> > {
+  typedef void (*Edge)(void);
+  typedef void (*Timed)(uint64_t timestamp_ns);
+
+  static const Edge *edges() {
+    static const Edge table[] = {&Handler<I>::edge...};
+    return table;
+  }
+  static const Timed *timed() {
+    static const Timed table[] = {&Handler<I>::timed...};
+    return table;
+  }
+};
+
+// Line offsets in counters[] order, for the chardev and poll backends
+template <size_t... I>
+inline const unsigned int *channelOffsets(ChannelIndices<I...>) {
+  static const unsigned int offsets[] = {CHANNEL_MAP[I].bcm...};
+  return offsets;
+}
+inline const unsigned int *channelOffsets() {
+  return channelOffsets(MakeChannelIndices<CHANNEL_COUNT>::type());
+}
+
+#endif //__CHANNELMAP_H__
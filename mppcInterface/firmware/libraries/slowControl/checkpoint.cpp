@@ -0,0 +1,124 @@
+// checkpoint.cpp — two-slot mmap'd journal of the window in progress
+// - One page, posix_fallocate'd on creation, mapped once
+// - save() fills the older slot and writes its checksum last; msync(MS_SYNC)
+//   every syncEvery saves bounds what a power cut can take
+// - A journal from another channel map is started afresh, not trusted
+// Build: g++ -O2 -std=c++11 -c checkpoint.cpp
+
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "checkpoint.h"
+
+#define PAGE 4096
+
+static_assert(sizeof(CheckpointFile) <= PAGE, "checkpoint journal is one page");
+
+// CRC-32 (IEEE, reflected), bitwise: ~100 bytes once a second
+static uint32_t crc32(const void *data, size_t length) {
+  const uint8_t *p = static_cast<const uint8_t *>(data);
+  uint32_t crc = 0xFFFFFFFFu;
+  while (length--) {
+    crc ^= *p++;
+    for (int k = 0; k < 8; k++) crc = crc >> 1 ^ (0xEDB88320u & -(crc & 1));
+  }
+  return ~crc;
+}
+
+static bool slotValid(const CheckpointSlot &slot) {
+  return slot.checksum == crc32(&slot, offsetof(CheckpointSlot, checksum));
+}
+
+CheckpointJournal::CheckpointJournal(uint32_t syncEvery) {
+  _file      = NULL;
+  _fd        = -1;
+  _seq       = 0;
+  _syncEvery = syncEvery ? syncEvery : 1;
+  _unsynced  = 0;
+}
+
+CheckpointJournal::~CheckpointJournal() {
+  if (_file) {
+    sync();
+    munmap(_file, PAGE);
+  }
+  if (_fd >= 0) close(_fd);
+}
+
+bool CheckpointJournal::open(const char filename[], CheckpointSlot &slot, bool &recovered) {
+  recovered = false;
+  _fd = ::open(filename, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (_fd < 0) {
+    std::perror("open checkpoint journal");
+    return false;
+  }
+
+  struct stat st;
+  fstat(_fd, &st);
+  // posix_fallocate returns its error, errno is left alone
+  int err = st.st_size < PAGE ? posix_fallocate(_fd, 0, PAGE) : 0;
+  if (err) {
+    std::fprintf(stderr, "allocate checkpoint journal: %s\n", std::strerror(err));
+    return false;
+  }
+
+  void *map = mmap(NULL, PAGE, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+  if (map == MAP_FAILED) {
+    std::perror("mmap checkpoint journal");
+    return false;
+  }
+  _file = static_cast<CheckpointFile *>(map);
+
+  if (std::memcmp(_file->magic, CHECKPOINT_MAGIC, sizeof(_file->magic)) != 0 ||
+      _file->channels != LOG_CHANNELS || _file->slotSize != sizeof(CheckpointSlot)) {
+    if (st.st_size) std::fprintf(stderr, "%s: not a journal of this channel map, starting afresh\n", filename);
+    std::memset(static_cast<void *>(_file), 0, sizeof(CheckpointFile));
+    std::memcpy(_file->magic, CHECKPOINT_MAGIC, sizeof(_file->magic));
+    _file->channels = LOG_CHANNELS;
+    _file->slotSize = sizeof(CheckpointSlot);
+    return sync();
+  }
+
+  const CheckpointSlot *newest = NULL;
+  for (int s = 0; s < 2; s++) {
+    const CheckpointSlot &candidate = _file->slots[s];
+    if (!slotValid(candidate)) continue;
+    if (!newest || candidate.seq > newest->seq) newest = &candidate;
+  }
+  if (newest) {
+    _seq = newest->seq;
+    slot = *newest;
+    recovered = slot.live_ns > 0;
+  }
+  return true;
+}
+
+void CheckpointJournal::save(uint64_t start_ns, uint64_t tickEnd_ns, uint64_t live_ns,
+                             const uint64_t counts[LOG_CHANNELS], uint32_t flags) {
+  if (!_file) return;
+  CheckpointSlot &slot = _file->slots[++_seq & 1];
+  slot.seq        = _seq;
+  slot.start_ns   = start_ns;
+  slot.tickEnd_ns = tickEnd_ns;
+  slot.live_ns    = live_ns;
+  for (size_t i = 0; i < LOG_CHANNELS; i++) slot.counts[i] = counts[i];
+  slot.flags      = flags;
+  slot.checksum   = crc32(&slot, offsetof(CheckpointSlot, checksum));
+
+  if (++_unsynced >= _syncEvery) sync();
+}
+
+bool CheckpointJournal::sync() {
+  if (!_file) return false;
+  _unsynced = 0;
+  if (msync(_file, PAGE, MS_SYNC) != 0) {
+    std::perror("msync checkpoint journal");
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,63 @@
+// Crash-safe journal of the window in progress.
+//
+// One preallocated, memory-mapped page holds two checkpoint slots. The main
+// loop saves the window so far into the older slot after every 1 s tick
+// (a ~100-byte store and a CRC-32, no system call) and msyncs the page every
+// syncEvery saves. A slot torn by a power cut fails its checksum and the
+// other one, one save older, is used instead.
+//
+// On start-up the newest valid slot is the window the previous run was
+// counting when it died: its start, the end of its last full tick, the live
+// time up to there and the counts.
+#ifndef __CHECKPOINT_H__
+#define __CHECKPOINT_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "logWriter.h"
+
+#define CHECKPOINT_MAGIC "MPPCCK01"
+
+struct CheckpointSlot {
+  uint64_t seq;            // save number, the newer slot wins
+  uint64_t start_ns;       // window start, ns since the epoch
+  uint64_t tickEnd_ns;     // end of the last tick counted
+  uint64_t live_ns;        // measured counting time up to tickEnd_ns
+  uint64_t counts[LOG_CHANNELS];
+  uint32_t flags;          // LOG_FLAG_* carried by the window so far
+  uint32_t checksum;       // CRC-32 of everything above
+};
+
+struct CheckpointFile {
+  char     magic[8];       // CHECKPOINT_MAGIC, not terminated
+  uint32_t channels;       // LOG_CHANNELS
+  uint32_t slotSize;       // sizeof(CheckpointSlot)
+  CheckpointSlot slots[2];
+};
+
+class CheckpointJournal {
+ public:
+  CheckpointJournal(uint32_t syncEvery);
+  ~CheckpointJournal();
+
+  // Maps the journal, creating it if needed. recovered is set when a valid
+  // checkpoint with counting time in it was left by a previous run.
+  bool open(const char filename[], CheckpointSlot &slot, bool &recovered);
+
+  void save(uint64_t start_ns, uint64_t tickEnd_ns, uint64_t live_ns,
+            const uint64_t counts[LOG_CHANNELS], uint32_t flags);
+
+  // msync now, regardless of syncEvery
+  bool sync();
+
+ private:
+
+  CheckpointFile *_file;
+  int _fd;
+  uint64_t _seq;
+  uint32_t _syncEvery;
+  uint32_t _unsynced;
+};
+
+#endif //__CHECKPOINT_H__
@@ -0,0 +1,221 @@
+// countStore.cpp — mmap'd columnar count store and its reader
+// - The writer maps the header/index once and one chunk at a time,
+//   new chunks are allocated with posix_fallocate (no SIGBUS on a full card)
+// - Row data and the index entry are written before header->rows moves,
+//   so a reader never sees a half-written row
+// - The reader maps the whole file read-only and never copies
+// Build: g++ -O2 -std=c++11 -c countStore.cpp
+
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "countStore.h"
+
+#define PAGE 4096
+#define INDEX_BYTES  (((STORE_MAX_CHUNKS * sizeof(StoreIndexEntry)) + PAGE - 1) / PAGE * PAGE)
+#define HEADER_BYTES (PAGE + INDEX_BYTES)
+#define COLUMN_BYTES (STORE_CHUNK_ROWS * sizeof(uint64_t))
+#define CHUNK_BYTES  (STORE_COLUMNS * COLUMN_BYTES)
+
+static off_t chunkOffset(uint32_t chunk) {
+  return (off_t)HEADER_BYTES + (off_t)chunk * CHUNK_BYTES;
+}
+
+CountStoreWriter::CountStoreWriter() {
+  _fd          = -1;
+  _header      = NULL;
+  _index       = NULL;
+  _chunk       = NULL;
+  _mappedChunk = 0;
+}
+
+CountStoreWriter::~CountStoreWriter() {
+  if (_chunk)  munmap(_chunk, CHUNK_BYTES);
+  if (_header) munmap(_header, HEADER_BYTES);
+  if (_fd >= 0) close(_fd);
+}
+
+bool CountStoreWriter::open(const char filename[]) {
+  _fd = ::open(filename, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (_fd < 0) {
+    std::perror("open count store");
+    return false;
+  }
+
+  struct stat st;
+  fstat(_fd, &st);
+  bool fresh = st.st_size == 0;
+  // posix_fallocate returns its error, errno is left alone
+  int err = fresh ? posix_fallocate(_fd, 0, HEADER_BYTES) : 0;
+  if (err) {
+    std::fprintf(stderr, "allocate count store: %s\n", std::strerror(err));
+    return false;
+  }
+
+  void *map = mmap(NULL, HEADER_BYTES, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+  if (map == MAP_FAILED) {
+    std::perror("mmap count store");
+    return false;
+  }
+  _header = static_cast<StoreHeader *>(map);
+  _index  = reinterpret_cast<StoreIndexEntry *>(static_cast<uint8_t *>(map) + PAGE);
+
+  if (fresh) {
+    std::memcpy(_header->magic, STORE_MAGIC, sizeof(_header->magic));
+    _header->columns   = STORE_COLUMNS;
+    _header->chunkRows = STORE_CHUNK_ROWS;
+    _header->maxChunks = STORE_MAX_CHUNKS;
+    _header->rows      = 0;
+  } else if (std::memcmp(_header->magic, STORE_MAGIC, sizeof(_header->magic)) != 0 ||
+             _header->columns != STORE_COLUMNS || _header->chunkRows != STORE_CHUNK_ROWS) {
+    std::fprintf(stderr, "ERROR: %s is not a compatible count store\n", filename);
+    return false;
+  }
+
+  return mapChunk(_header->rows / STORE_CHUNK_ROWS);
+}
+
+bool CountStoreWriter::mapChunk(uint32_t chunk) {
+  if (chunk >= STORE_MAX_CHUNKS) {
+    std::fprintf(stderr, "ERROR: count store full\n");
+    return false;
+  }
+  if (_chunk) munmap(_chunk, CHUNK_BYTES);
+  _chunk = NULL;
+
+  int err = posix_fallocate(_fd, chunkOffset(chunk), CHUNK_BYTES);
+  if (err) {
+    std::fprintf(stderr, "allocate count store chunk: %s\n", std::strerror(err));
+    return false;
+  }
+  void *map = mmap(NULL, CHUNK_BYTES, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, chunkOffset(chunk));
+  if (map == MAP_FAILED) {
+    std::perror("mmap count store chunk");
+    return false;
+  }
+  _chunk = static_cast<uint64_t *>(map);
+  _mappedChunk = chunk;
+  return true;
+}
+
+bool CountStoreWriter::append(const LogRecord &record) {
+  if (!_header) return false;
+
+  uint64_t row = _header->rows;
+  uint32_t chunk = row / STORE_CHUNK_ROWS;
+  uint32_t slot  = row % STORE_CHUNK_ROWS;
+
+  // The index is only searchable while time keeps increasing
+  if (row > 0 && record.end_ns <= _index[(row - 1) / STORE_CHUNK_ROWS].last_ns) {
+    std::fprintf(stderr, "Count store: window %llu not after the last one, skipped\n",
+                 (unsigned long long)record.end_ns);
+    return false;
+  }
+
+  if (chunk != _mappedChunk || !_chunk) {
+    if (!mapChunk(chunk)) return false;
+  }
+
+  _chunk[COL_TIME  * STORE_CHUNK_ROWS + slot] = record.end_ns;
+  _chunk[COL_LIVE  * STORE_CHUNK_ROWS + slot] = record.live_ns;
+  _chunk[COL_FLAGS * STORE_CHUNK_ROWS + slot] = record.flags;
+  for (size_t i = 0; i < LOG_CHANNELS; i++)
+    _chunk[(COL_COUNT0 + i) * STORE_CHUNK_ROWS + slot] = record.counts[i];
+
+  if (slot == 0) _index[chunk].first_ns = record.end_ns;
+  _index[chunk].last_ns = record.end_ns;
+
+  __atomic_store_n(&_header->rows, row + 1, __ATOMIC_RELEASE);
+  return true;
+}
+
+CountStoreReader::CountStoreReader() {
+  _fd     = -1;
+  _map    = NULL;
+  _length = 0;
+  _header = NULL;
+  _index  = NULL;
+}
+
+CountStoreReader::~CountStoreReader() {
+  if (_map) munmap(const_cast<uint8_t *>(_map), _length);
+  if (_fd >= 0) close(_fd);
+}
+
+bool CountStoreReader::open(const char filename[]) {
+  _fd = ::open(filename, O_RDONLY | O_CLOEXEC);
+  if (_fd < 0) {
+    std::perror("open count store");
+    return false;
+  }
+
+  struct stat st;
+  fstat(_fd, &st);
+  if ((size_t)st.st_size < HEADER_BYTES) {
+    std::fprintf(stderr, "ERROR: %s is too short for a count store\n", filename);
+    return false;
+  }
+  _length = st.st_size;
+
+  void *map = mmap(NULL, _length, PROT_READ, MAP_SHARED, _fd, 0);
+  if (map == MAP_FAILED) {
+    std::perror("mmap count store");
+    return false;
+  }
+  _map    = static_cast<const uint8_t *>(map);
+  _header = reinterpret_cast<const StoreHeader *>(_map);
+  _index  = reinterpret_cast<const StoreIndexEntry *>(_map + PAGE);
+
+  if (std::memcmp(_header->magic, STORE_MAGIC, sizeof(_header->magic)) != 0 ||
+      _header->columns != STORE_COLUMNS || _header->chunkRows != STORE_CHUNK_ROWS) {
+    std::fprintf(stderr, "ERROR: %s is not a compatible count store\n", filename);
+    return false;
+  }
+  return true;
+}
+
+uint64_t CountStoreReader::rows() const {
+  if (!_header) return 0;
+  // Only rows inside the part of the file we mapped
+  uint64_t mapped = (_length - HEADER_BYTES) / CHUNK_BYTES * STORE_CHUNK_ROWS;
+  uint64_t rows = __atomic_load_n(&_header->rows, __ATOMIC_ACQUIRE);
+  return rows < mapped ? rows : mapped;
+}
+
+const uint64_t *CountStoreReader::column(uint32_t chunk, int col) const {
+  return reinterpret_cast<const uint64_t *>(_map + chunkOffset(chunk) + col * COLUMN_BYTES);
+}
+
+size_t CountStoreReader::range(uint64_t from_ns, uint64_t to_ns, StoreSlice *out, size_t max) const {
+  uint64_t total = rows();
+  if (total == 0 || from_ns >= to_ns) return 0;
+  uint32_t chunks = (total + STORE_CHUNK_ROWS - 1) / STORE_CHUNK_ROWS;
+
+  // First chunk that ends at or after from_ns
+  uint32_t lo = 0, hi = chunks;
+  while (lo < hi) {
+    uint32_t mid = (lo + hi) / 2;
+    if (_index[mid].last_ns < from_ns) lo = mid + 1;
+    else hi = mid;
+  }
+
+  size_t n = 0;
+  for (uint32_t c = lo; c < chunks && n < max && _index[c].first_ns < to_ns; c++) {
+    size_t rowsInChunk = c + 1 < chunks ? STORE_CHUNK_ROWS : total - (uint64_t)c * STORE_CHUNK_ROWS;
+    const uint64_t *time = column(c, COL_TIME);
+    size_t begin = std::lower_bound(time, time + rowsInChunk, from_ns) - time;
+    size_t end   = std::lower_bound(time + begin, time + rowsInChunk, to_ns) - time;
+    if (begin == end) continue;
+
+    StoreSlice &s = out[n++];
+    s.rows = end - begin;
+    for (int col = 0; col < STORE_COLUMNS; col++) s.columns[col] = column(c, col) + begin;
+  }
+  return n;
+}
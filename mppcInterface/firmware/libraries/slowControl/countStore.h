@@ -0,0 +1,95 @@
+// Memory-mapped columnar store of slowControl windows.
+//
+// File layout (all little endian, page aligned):
+//   StoreHeader                      first page
+//   StoreIndexEntry[STORE_MAX_CHUNKS] first/last timestamp of every chunk
+//   chunks                           STORE_COLUMNS columns of
+//                                    STORE_CHUNK_ROWS uint64_t each
+//
+// Rows are appended in timestamp order. A time range is found by binary
+// search over the index, then inside the first and last chunk's time column,
+// and handed back as pointers straight into the mapping, no parsing.
+#ifndef __COUNTSTORE_H__
+#define __COUNTSTORE_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "logWriter.h"
+
+#define STORE_MAGIC      "MPPCCS01"
+#define STORE_CHUNK_ROWS 4096   // ~2.8 days of minute windows per chunk
+#define STORE_MAX_CHUNKS 8192   // ~64 years of minute windows
+
+// Column order inside a chunk
+enum StoreColumn {
+  COL_TIME = 0,   // window end, ns since the epoch (sort key)
+  COL_LIVE,       // live time, ns
+  COL_FLAGS,      // LOG_FLAG_* bits
+  COL_COUNT0,     // counts[0] .. counts[LOG_CHANNELS-1] follow
+  STORE_COLUMNS = COL_COUNT0 + LOG_CHANNELS
+};
+
+struct StoreHeader {
+  char     magic[8];     // STORE_MAGIC, not terminated
+  uint32_t columns;
+  uint32_t chunkRows;
+  uint32_t maxChunks;
+  uint32_t reserved;
+  uint64_t rows;           // committed rows, published after the data
+};
+
+struct StoreIndexEntry {
+  uint64_t first_ns;
+  uint64_t last_ns;
+};
+
+// Rows of one chunk that fall inside a queried range
+struct StoreSlice {
+  size_t rows;
+  const uint64_t *columns[STORE_COLUMNS];
+};
+
+class CountStoreWriter {
+ public:
+  CountStoreWriter();
+  ~CountStoreWriter();
+
+  bool open(const char filename[]);
+  bool append(const LogRecord &record);
+
+ private:
+
+  bool mapChunk(uint32_t chunk);
+
+  int _fd;
+  StoreHeader *_header;
+  StoreIndexEntry *_index;
+  uint64_t *_chunk;
+  uint32_t _mappedChunk;
+};
+
+class CountStoreReader {
+ public:
+  CountStoreReader();
+  ~CountStoreReader();
+
+  bool open(const char filename[]);
+  uint64_t rows() const;
+
+  // Slices covering every row with from_ns <= time < to_ns, in time order.
+  // Returns how many were written to out (at most max).
+  size_t range(uint64_t from_ns, uint64_t to_ns, StoreSlice *out, size_t max) const;
+
+ private:
+
+  const uint64_t *column(uint32_t chunk, int col) const;
+
+  int _fd;
+  const uint8_t *_map;
+  size_t _length;
+  const StoreHeader *_header;
+  const StoreIndexEntry *_index;
+};
+
+#endif //__COUNTSTORE_H__
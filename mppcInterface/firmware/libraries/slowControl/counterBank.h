@@ -0,0 +1,70 @@
+// Double-buffered 64-bit edge counters with lossless window rollover.
+//
+// Handlers increment the active bank. rollover() flips the epoch so new
+// edges go to the other bank, then drains the retired one with exchange(0).
+// Nothing on the hot path takes a lock, and every increment is reported
+// exactly once: one that loaded the old epoch just before the flip and lands
+// after the drain simply stays in that bank and is reported when it is
+// retired again.
+#ifndef __COUNTERBANK_H__
+#define __COUNTERBANK_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <thread>
+#include <chrono>
+
+#ifndef CACHE_LINE
+#define CACHE_LINE 64
+#endif
+
+// Time given to handlers that read the old epoch before the drain
+#define ROLLOVER_GRACE_US 50
+
+template <size_t N>
+class CounterBank {
+ public:
+  CounterBank() : _active(0) {
+    for (int b = 0; b < 2; b++)
+      for (size_t i = 0; i < N; i++) _banks[b][i].count.store(0, std::memory_order_relaxed);
+  }
+
+  // Hot path, any thread
+  inline void increment(size_t channel) {
+    uint32_t b = _active.load(std::memory_order_acquire);
+    _banks[b][channel].count.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Several edges at once, for counts that arrive already summed
+  inline void add(size_t channel, uint64_t n) {
+    uint32_t b = _active.load(std::memory_order_acquire);
+    _banks[b][channel].count.fetch_add(n, std::memory_order_relaxed);
+  }
+
+  // Counts of the active window so far, without closing it
+  uint64_t peek(size_t channel) const {
+    return _banks[_active.load(std::memory_order_acquire)][channel].count.load(std::memory_order_relaxed);
+  }
+
+  // Close the window: out[i] receives every count since the last rollover
+  void rollover(uint64_t out[N]) {
+    uint32_t retired = _active.load(std::memory_order_relaxed);
+    _active.store(retired ^ 1, std::memory_order_seq_cst);
+    std::this_thread::sleep_for(std::chrono::microseconds(ROLLOVER_GRACE_US));
+    for (size_t i = 0; i < N; i++)
+      out[i] = _banks[retired][i].count.exchange(0, std::memory_order_acq_rel);
+  }
+
+ private:
+
+  // One counter per cache line, so per-channel handler threads never share one
+  struct alignas(CACHE_LINE) Slot {
+    std::atomic<uint64_t> count;
+  };
+
+  Slot _banks[2][N];
+  alignas(CACHE_LINE) std::atomic<uint32_t> _active;
+};
+
+#endif //__COUNTERBANK_H__
@@ -0,0 +1,105 @@
+// edgeDispatcher.cpp — one epoll thread for every slowControl input
+// - Level triggered, so a source that still has data fires again next wait
+// - stop() wakes the thread through an eventfd in the same set
+// Build: g++ -O2 -std=c++11 -c edgeDispatcher.cpp (link -lpthread)
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#include "edgeDispatcher.h"
+
+// Tag of the stop eventfd, never handed to a source
+#define STOP_SOURCE 0xFF
+
+EdgeDispatcher::EdgeDispatcher() {
+  _nSources = 0;
+  _wakeups  = 0;
+  _serviced = 0;
+
+  _epfd   = epoll_create1(EPOLL_CLOEXEC);
+  _stopfd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (_epfd < 0 || _stopfd < 0) {
+    std::perror("epoll/eventfd");
+    return;
+  }
+
+  struct epoll_event ev;
+  std::memset(&ev, 0, sizeof(ev));
+  ev.events = EPOLLIN;
+  ev.data.u32 = STOP_SOURCE;
+  epoll_ctl(_epfd, EPOLL_CTL_ADD, _stopfd, &ev);
+}
+
+EdgeDispatcher::~EdgeDispatcher() {
+  stop();
+  if (_stopfd >= 0) close(_stopfd);
+  if (_epfd >= 0)   close(_epfd);
+}
+
+bool EdgeDispatcher::add(int fd, ReadyHandler handler, void *ctx, uint32_t tag) {
+  if (_epfd < 0 || _nSources >= DISPATCHER_MAX_SOURCES) return false;
+
+  Source &s = _sources[_nSources];
+  s.handler = handler;
+  s.ctx     = ctx;
+  s.tag     = tag;
+
+  struct epoll_event ev;
+  std::memset(&ev, 0, sizeof(ev));
+  ev.events = EPOLLIN;
+  ev.data.u32 = _nSources;
+  if (epoll_ctl(_epfd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+    std::perror("epoll_ctl");
+    return false;
+  }
+  _nSources++;
+  return true;
+}
+
+bool EdgeDispatcher::remove(int fd) {
+  if (epoll_ctl(_epfd, EPOLL_CTL_DEL, fd, NULL) < 0) {
+    std::perror("epoll_ctl");
+    return false;
+  }
+  return true;
+}
+
+bool EdgeDispatcher::start() {
+  if (_epfd < 0) return false;
+  _thread = std::thread(&EdgeDispatcher::run, this);
+  return true;
+}
+
+void EdgeDispatcher::stop() {
+  if (!_thread.joinable()) return;
+  uint64_t one = 1;
+  if (write(_stopfd, &one, sizeof(one)) < 0) std::perror("eventfd write");
+  _thread.join();
+}
+
+void EdgeDispatcher::run() {
+  struct epoll_event ready[DISPATCHER_MAX_SOURCES + 1];
+
+  while (1) {
+    int n = epoll_wait(_epfd, ready, DISPATCHER_MAX_SOURCES + 1, -1);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      std::perror("epoll_wait");
+      return;
+    }
+
+    for (int i = 0; i < n; i++) {
+      uint32_t idx = ready[i].data.u32;
+      if (idx == STOP_SOURCE) return;
+      Source &s = _sources[idx];
+      s.handler(s.ctx, s.tag);
+    }
+    _wakeups++;
+    _serviced += n;
+  }
+}
@@ -0,0 +1,56 @@
+// Single-thread epoll dispatcher for slowControl input descriptors.
+// Every registered fd is waited on in one epoll set; all ready fds are
+// serviced in the same wakeup.
+#ifndef __EDGEDISPATCHER_H__
+#define __EDGEDISPATCHER_H__
+
+#include <stdint.h>
+#include <thread>
+
+#define DISPATCHER_MAX_SOURCES 16
+
+class EdgeDispatcher {
+ public:
+  // Called from the dispatcher thread when fd is readable
+  typedef void (*ReadyHandler)(void *ctx, uint32_t tag);
+
+  EdgeDispatcher();
+  ~EdgeDispatcher();
+
+  bool add(int fd, ReadyHandler handler, void *ctx, uint32_t tag);
+
+  // Stop waiting on fd, from a handler whose source failed for good; a
+  // level triggered fd that can no longer be read would be ready forever
+  bool remove(int fd);
+  bool start();
+  void stop();
+
+  // Wakeups that serviced at least one fd, and fds serviced in total
+  uint64_t wakeups() const { return _wakeups; }
+  uint64_t serviced() const { return _serviced; }
+
+  // For scheduling policy and affinity, valid after start()
+  std::thread::native_handle_type handle() { return _thread.native_handle(); }
+
+ private:
+
+  struct Source {
+    ReadyHandler handler;
+    void *ctx;
+    uint32_t tag;
+  };
+
+  void run();
+
+  int _epfd;
+  int _stopfd;
+  Source _sources[DISPATCHER_MAX_SOURCES];
+  uint8_t _nSources;
+
+  volatile uint64_t _wakeups;
+  volatile uint64_t _serviced;
+
+  std::thread _thread;
+};
+
+#endif //__EDGEDISPATCHER_H__
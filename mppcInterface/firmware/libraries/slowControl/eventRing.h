@@ -0,0 +1,86 @@
+// Single-producer/single-consumer ring of timestamped edges.
+// The producer (edge dispatcher) never blocks or allocates: a push into a
+// full ring is counted as an overrun and the edge is dropped from the stream.
+#ifndef __EVENTRING_H__
+#define __EVENTRING_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+#ifndef CACHE_LINE
+#define CACHE_LINE 64
+#endif
+
+// Channel value of the marker record written after an overrun
+#define EVENT_OVERRUN 0xFF
+
+// EdgeEvent flags
+#define EVENT_FLAG_FPGA 0x01   // stamped by the FPGA (-T), channel is the FPGA's
+
+// One edge as stored in the ring and in the event file, 16 bytes
+struct EdgeEvent {
+  uint64_t timestamp_ns;  // CLOCK_MONOTONIC
+  uint8_t  channel;       // counter index, or EVENT_OVERRUN
+  uint8_t  flags;
+  uint16_t reserved;
+  uint32_t aux;           // EVENT_OVERRUN: edges dropped since the last marker
+};
+
+// Capacity must be a power of two
+template <size_t Capacity>
+class EventRing {
+ public:
+  EventRing() : _head(0), _overruns(0), _cachedTail(0), _tail(0), _cachedHead(0) {}
+
+  // Producer side, wait-free
+  bool push(uint8_t channel, uint64_t timestamp_ns, uint8_t flags = 0) {
+    uint64_t head = _head.load(std::memory_order_relaxed);
+    if (head - _cachedTail >= Capacity) {
+      _cachedTail = _tail.load(std::memory_order_acquire);
+      if (head - _cachedTail >= Capacity) {
+        _overruns.store(_overruns.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return false;
+      }
+    }
+    EdgeEvent &e = _slots[head & (Capacity - 1)];
+    e.timestamp_ns = timestamp_ns;
+    e.channel      = channel;
+    e.flags        = flags;
+    e.reserved     = 0;
+    e.aux          = 0;
+    _head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side, copies up to max events out, returns how many
+  size_t pop(EdgeEvent *out, size_t max) {
+    uint64_t tail = _tail.load(std::memory_order_relaxed);
+    if (_cachedHead == tail) _cachedHead = _head.load(std::memory_order_acquire);
+    size_t n = static_cast<size_t>(_cachedHead - tail);
+    if (n > max) n = max;
+    for (size_t i = 0; i < n; i++) out[i] = _slots[(tail + i) & (Capacity - 1)];
+    _tail.store(tail + n, std::memory_order_release);
+    return n;
+  }
+
+  // Edges dropped because the ring was full, total since start
+  uint64_t overruns() const { return _overruns.load(std::memory_order_relaxed); }
+
+ private:
+
+  static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+  // Producer and consumer state on separate cache lines
+  alignas(CACHE_LINE) std::atomic<uint64_t> _head;
+  std::atomic<uint64_t> _overruns;
+  uint64_t _cachedTail;   // producer's copy of _tail
+  alignas(CACHE_LINE) std::atomic<uint64_t> _tail;
+  uint64_t _cachedHead;   // consumer's copy of _head
+  alignas(CACHE_LINE) EdgeEvent _slots[Capacity];
+};
+
+// 64k edges, a second of 65 kHz input before the writer has to catch up
+typedef EventRing<65536> EdgeRing;
+
+#endif //__EVENTRING_H__
@@ -0,0 +1,111 @@
+// eventWriter.cpp — binary event stream for slowControl's event mode
+// - Drains the SPSC ring in blocks of EVENT_WRITE_BATCH records per write()
+// - Sleeps IDLE_SLEEP_US when the ring is empty, the ring absorbs the gap
+// - Overruns are logged to stderr and marked in the file, never silent
+// Build: g++ -O2 -std=c++11 -c eventWriter.cpp (link -lpthread)
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "eventWriter.h"
+
+// Poll interval of an empty ring
+#define IDLE_SLEEP_US 5000
+
+EventWriter::EventWriter(EdgeRing &ring, uint32_t channels) : _ring(ring) {
+  _channels       = channels;
+  _fd             = -1;
+  _written        = 0;
+  _overrunsLogged = 0;
+  _running        = false;
+}
+
+EventWriter::~EventWriter() {
+  stop();
+}
+
+bool EventWriter::open(const char filename[]) {
+  _fd = ::open(filename, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+  if (_fd < 0) {
+    std::perror("open event file");
+    return false;
+  }
+
+  struct timespec mono, real;
+  clock_gettime(CLOCK_MONOTONIC, &mono);
+  clock_gettime(CLOCK_REALTIME, &real);
+
+  EventFileHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, EVENT_FILE_MAGIC, sizeof(header.magic));
+  header.recordSize = sizeof(EdgeEvent);
+  header.channels   = _channels;
+  header.realtimeOffset_ns = (int64_t)(real.tv_sec - mono.tv_sec) * 1000000000LL +
+                             (real.tv_nsec - mono.tv_nsec);
+  if (!writeAll(&header, sizeof(header))) return false;
+
+  _running = true;
+  _thread = std::thread(&EventWriter::run, this);
+  return true;
+}
+
+void EventWriter::stop() {
+  _running = false;
+  if (_thread.joinable()) _thread.join();
+  if (_fd >= 0) {
+    drain();
+    close(_fd);
+    _fd = -1;
+  }
+}
+
+void EventWriter::run() {
+  while (_running) {
+    drain();
+    usleep(IDLE_SLEEP_US);
+  }
+}
+
+void EventWriter::drain() {
+  size_t n;
+  while ((n = _ring.pop(_batch, EVENT_WRITE_BATCH)) > 0) {
+    if (writeAll(_batch, n * sizeof(EdgeEvent))) _written += n;
+  }
+
+  uint64_t overruns = _ring.overruns();
+  if (overruns != _overrunsLogged) {
+    uint64_t dropped = overruns - _overrunsLogged;
+    _overrunsLogged = overruns;
+    std::fprintf(stderr, "Event ring overrun: %llu edges dropped (%llu total)\n",
+                 (unsigned long long)dropped, (unsigned long long)overruns);
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    EdgeEvent marker;
+    std::memset(&marker, 0, sizeof(marker));
+    marker.timestamp_ns = (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+    marker.channel      = EVENT_OVERRUN;
+    marker.aux          = dropped > 0xFFFFFFFFULL ? 0xFFFFFFFFU : (uint32_t)dropped;
+    writeAll(&marker, sizeof(marker));
+  }
+}
+
+bool EventWriter::writeAll(const void *data, size_t length) {
+  const char *p = static_cast<const char *>(data);
+  while (length > 0) {
+    ssize_t n = write(_fd, p, length);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      std::perror("write event file");
+      return false;
+    }
+    p += n;
+    length -= n;
+  }
+  return true;
+}
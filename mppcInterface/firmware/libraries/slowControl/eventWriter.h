@@ -0,0 +1,52 @@
+// Writer thread that drains the edge ring into a binary event file.
+//
+// File layout: one EventFileHeader, then EdgeEvent records (16 bytes each,
+// little endian). After an overrun the writer inserts a record with
+// channel == EVENT_OVERRUN whose aux field holds the number of dropped edges.
+#ifndef __EVENTWRITER_H__
+#define __EVENTWRITER_H__
+
+#include <stdint.h>
+#include <thread>
+
+#include "eventRing.h"
+
+#define EVENT_FILE_MAGIC "MPPCEV01"
+#define EVENT_WRITE_BATCH 4096   // records per write() call, 64 KiB
+
+struct EventFileHeader {
+  char     magic[8];           // EVENT_FILE_MAGIC, not terminated
+  uint32_t recordSize;         // sizeof(EdgeEvent)
+  uint32_t channels;
+  int64_t  realtimeOffset_ns;  // CLOCK_REALTIME - CLOCK_MONOTONIC at open
+  uint64_t reserved;
+};
+
+class EventWriter {
+ public:
+  EventWriter(EdgeRing &ring, uint32_t channels);
+  ~EventWriter();
+
+  bool open(const char filename[]);
+  void stop();
+
+  uint64_t written() const { return _written; }
+
+ private:
+
+  void run();
+  void drain();
+  bool writeAll(const void *data, size_t length);
+
+  EdgeRing &_ring;
+  uint32_t _channels;
+  int _fd;
+  uint64_t _written;
+  uint64_t _overrunsLogged;
+  EdgeEvent _batch[EVENT_WRITE_BATCH];   // one per writer, -T runs two
+
+  std::thread _thread;
+  volatile bool _running;
+};
+
+#endif //__EVENTWRITER_H__
@@ -0,0 +1,190 @@
+// fpgaCoincidences.cpp — read and write the FPGA's coincidence registers
+// - One 25-byte transaction either way: command, then registers 0-5 as
+//   big-endian 32-bit words; the FPGA applies a write when CS goes high
+// - Register 0 (the id) is read-only, so writes carry whatever and the
+//   id read back doubles as the check that the registers exist
+// - Shares the SPI port with FpgaCounters and FpgaHits under fpgaSpiMutex()
+// Build: g++ -O2 -std=c++11 -I../hal -c fpgaCoincidences.cpp (see ../hal/hal.mk)
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "fpgaCoincidences.h"
+
+#define REG_ID     0
+#define REG_WINDOW 1
+#define REG_OUTPUT 2
+
+static uint32_t encodeOutput(const FpgaCoincidence &o) {
+  return (uint32_t)(o.threshold & 0x7) << 8 | (o.mask & 0xF);
+}
+
+FpgaLayout fpgaDefaultLayout() {
+  FpgaLayout layout = {0, {{0x03, 2}, {0x05, 2}, {0x06, 2}, {0x07, 3}}};
+  return layout;
+}
+
+int fpgaBankWord(uint8_t mask, const FpgaLayout &layout) {
+  for (int c = 0; c < FPGA_COINC_CHANNELS; c++)
+    if (mask == 1 << c) return c;
+  unsigned bits = 0;
+  for (uint8_t m = mask; m; m >>= 1) bits += m & 1;
+  for (int o = 0; mask && o < FPGA_COINC_OUTPUTS; o++)
+    if (layout.outputs[o].mask == mask && layout.outputs[o].threshold == bits) return FPGA_COINC_CHANNELS + o;
+  return -1;
+}
+
+// "0x03" or "CH0&&CH1", FPGA channels only; 0 for an output that is off
+static bool parseMask(const char text[], uint8_t &mask) {
+  char *end;
+  unsigned long value = std::strtoul(text, &end, 0);
+  if (end != text && *end == 0) {
+    mask = value;
+    return value < 1u << FPGA_COINC_CHANNELS;
+  }
+  mask = 0;
+  for (const char *p = text; *p;) {
+    if (std::strncmp(p, "CH", 2) || p[2] < '0' || p[2] >= '0' + FPGA_COINC_CHANNELS) return false;
+    mask |= 1 << (p[2] - '0');
+    p += 3;
+    if (!std::strncmp(p, "&&", 2)) p += 2;
+    else if (*p) return false;
+  }
+  return mask != 0;
+}
+
+bool loadFpgaLayout(const char path[], FpgaLayout &layout) {
+  FILE *f = std::fopen(path, "r");
+  if (!f) {
+    std::perror(path);
+    return false;
+  }
+  std::memset(&layout, 0, sizeof(layout));
+
+  char line[256];
+  int lineNo = 0;
+  bool ok = true;
+  while (ok && std::fgets(line, sizeof(line), f)) {
+    lineNo++;
+    char *hash = std::strchr(line, '#');
+    if (hash) *hash = 0;
+
+    char key[16], channels[64];
+    unsigned long a, b;
+    int n = std::sscanf(line, "%15s", key);
+    if (n < 1) continue;
+    if (!std::strcmp(key, "window")) {
+      ok = std::sscanf(line, "%*s %lu", &a) == 1 && a <= 0xFFFF;
+      if (ok) layout.window = a;
+    } else if (!std::strcmp(key, "output")) {
+      uint8_t mask = 0;
+      ok = std::sscanf(line, "%*s %lu %63s %lu", &a, channels, &b) == 3 && a < FPGA_COINC_OUTPUTS &&
+           parseMask(channels, mask) && b <= FPGA_COINC_CHANNELS;
+      // More hits than the mask has channels never fires, an off output takes threshold 0
+      ok = ok && b <= (unsigned long)__builtin_popcount(mask) && (mask || b == 0);
+      if (ok) {
+        layout.outputs[a].mask      = mask;
+        layout.outputs[a].threshold = b;
+      }
+    } else {
+      ok = false;
+    }
+    if (!ok) std::fprintf(stderr, "%s:%d: expected 'window <cycles>' or 'output <0-3> <channels> <threshold>'\n", path, lineNo);
+  }
+  std::fclose(f);
+  return ok;
+}
+
+void printFpgaLayout(FILE *out, const FpgaLayout &layout) {
+  std::fprintf(out, "window %u\n", layout.window);
+  for (int o = 0; o < FPGA_COINC_OUTPUTS; o++) {
+    char channels[32] = "";
+    for (int c = 0; c < FPGA_COINC_CHANNELS; c++) {
+      if (!(layout.outputs[o].mask >> c & 1)) continue;
+      size_t len = std::strlen(channels);
+      std::snprintf(channels + len, sizeof(channels) - len, "%sCH%d", len ? "&&" : "", c);
+    }
+    if (!layout.outputs[o].mask) std::snprintf(channels, sizeof(channels), "0");
+    std::fprintf(out, "output %d %s %u\n", o, channels, layout.outputs[o].threshold);
+  }
+}
+
+FpgaCoincidences::FpgaCoincidences(unsigned csPin, uint8_t spiChannel) : _hal(hal()) {
+  _csPin      = csPin;
+  _spiChannel = spiChannel;
+}
+
+bool FpgaCoincidences::open() {
+  if (!_hal.setup()) return false;
+  if (!_hal.spiSetup(_spiChannel, FPGA_SPI_HZ, 0)) {
+    std::perror("FPGA spiSetup");
+    return false;
+  }
+  _hal.pinMode(_csPin, HAL_OUTPUT);
+  _hal.digitalWrite(_csPin, 1);
+
+  uint32_t regs[FPGA_COINC_REGS] = {0};
+  if (!transfer(FPGA_CMD_READ_REGS, regs) || regs[REG_ID] != FPGA_COINC_ID) {
+    std::fprintf(stderr, "No coincidence registers on the FPGA, is the bitstream built with coincidenceRegs.v?\n");
+    return false;
+  }
+  return true;
+}
+
+bool FpgaCoincidences::transfer(uint8_t command, uint32_t regs[FPGA_COINC_REGS]) {
+  uint8_t data[1 + 4 * FPGA_COINC_REGS] = {command};
+  for (int r = 0; r < FPGA_COINC_REGS; r++) {
+    uint8_t *p = &data[1 + 4 * r];
+    p[0] = regs[r] >> 24;
+    p[1] = regs[r] >> 16;
+    p[2] = regs[r] >> 8;
+    p[3] = regs[r];
+  }
+  int n;
+  {
+    std::lock_guard<std::mutex> guard(fpgaSpiMutex());
+    _hal.digitalWrite(_csPin, 0);
+    n = _hal.spiTransfer(_spiChannel, data, sizeof(data));
+    _hal.digitalWrite(_csPin, 1);
+  }
+  if (n != (int)sizeof(data)) {
+    std::perror("FPGA spiTransfer");
+    return false;
+  }
+  for (int r = 0; r < FPGA_COINC_REGS; r++) {
+    const uint8_t *p = &data[1 + 4 * r];
+    regs[r] = (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+  }
+  return true;
+}
+
+bool FpgaCoincidences::read(FpgaLayout &layout) {
+  uint32_t regs[FPGA_COINC_REGS] = {0};
+  if (!transfer(FPGA_CMD_READ_REGS, regs)) return false;
+  if (regs[REG_ID] != FPGA_COINC_ID) {
+    std::fprintf(stderr, "FPGA coincidence registers read back id %08x\n", regs[REG_ID]);
+    return false;
+  }
+  layout.window = regs[REG_WINDOW] & 0xFFFF;
+  for (int o = 0; o < FPGA_COINC_OUTPUTS; o++) {
+    layout.outputs[o].mask      = regs[REG_OUTPUT + o] & 0xF;
+    layout.outputs[o].threshold = regs[REG_OUTPUT + o] >> 8 & 0x7;
+  }
+  return true;
+}
+
+bool FpgaCoincidences::write(const FpgaLayout &layout) {
+  uint32_t regs[FPGA_COINC_REGS] = {0};
+  regs[REG_WINDOW] = layout.window;
+  for (int o = 0; o < FPGA_COINC_OUTPUTS; o++) regs[REG_OUTPUT + o] = encodeOutput(layout.outputs[o]);
+  if (!transfer(FPGA_CMD_WRITE_REGS, regs)) return false;
+
+  FpgaLayout back;
+  if (!read(back)) return false;
+  bool same = back.window == layout.window;
+  for (int o = 0; o < FPGA_COINC_OUTPUTS; o++)
+    same = same && encodeOutput(back.outputs[o]) == encodeOutput(layout.outputs[o]);
+  if (!same) std::fprintf(stderr, "FPGA coincidence registers did not take the layout\n");
+  return same;
+}
@@ -0,0 +1,73 @@
+// Coincidence registers of the FPGA (gateware coincidenceRegs.v).
+//
+// Bank words 4-7, and the Pi's coincidence pins, count four programmable
+// outputs: a channel mask, a majority threshold and one window length in
+// CLK cycles shared by all four. A layout is written in one SPI transaction
+// and takes effect on a single FPGA clock edge, so changing it costs
+// microseconds and the counters never stop. fpgaLayout sets the site's
+// layout from a config file at boot.
+#ifndef __FPGACOINCIDENCES_H__
+#define __FPGACOINCIDENCES_H__
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "fpgaCounters.h"
+
+#define FPGA_CMD_WRITE_REGS 0x04
+#define FPGA_CMD_READ_REGS  0x05
+#define FPGA_COINC_ID       0xC5010404   // register 0: version 1, 4 outputs, 4 channels
+#define FPGA_COINC_REGS     6
+#define FPGA_COINC_OUTPUTS  4
+#define FPGA_COINC_CHANNELS 4
+
+struct FpgaCoincidence {
+  uint8_t mask;         // FPGA CHn, bit n
+  uint8_t threshold;    // channels of mask needed, 0 = off
+};
+
+struct FpgaLayout {
+  uint16_t window;      // CLK cycles, 0 = channel levels ANDed as they are
+  FpgaCoincidence outputs[FPGA_COINC_OUTPUTS];
+};
+
+// What the registers hold at configuration, the fixed bitstreams' layout:
+// CH0&&CH1, CH0&&CH2, CH1&&CH2, CH0&&CH1&&CH2
+FpgaLayout fpgaDefaultLayout();
+
+// Bank word counting FPGA channels mask (CHANNEL_MAP fpgaMask): a raw
+// channel's own word, or the first output requiring every channel of the
+// mask and no other. -1 if the bank has no counter for it.
+int fpgaBankWord(uint8_t mask, const FpgaLayout &layout = fpgaDefaultLayout());
+
+// Config file, one setting per line, # comments:
+//   window <cycles>
+//   output <n> <mask or CH0&&CH1...> <threshold>
+// Outputs not named are switched off. false with a message on a bad line.
+bool loadFpgaLayout(const char path[], FpgaLayout &layout);
+
+// The layout in the config file's syntax
+void printFpgaLayout(FILE *out, const FpgaLayout &layout);
+
+class FpgaCoincidences {
+ public:
+  FpgaCoincidences(unsigned csPin = FPGA_CS_PIN, uint8_t spiChannel = 0);
+
+  // false if the bitstream has no register file
+  bool open();
+
+  bool read(FpgaLayout &layout);
+
+  // Writes every register, then reads them back to check
+  bool write(const FpgaLayout &layout);
+
+ private:
+
+  bool transfer(uint8_t command, uint32_t regs[FPGA_COINC_REGS]);
+
+  Hal &_hal;
+  unsigned _csPin;
+  uint8_t _spiChannel;
+};
+
+#endif //__FPGACOINCIDENCES_H__
@@ -0,0 +1,95 @@
+// fpgaCounters.cpp — SPI burst reads of the FPGA's latched counter bank
+// - SPI mode 0 at FPGA_SPI_HZ, CS driven by hand on the upload's CS pin
+// - One 33-byte transaction: command, then 8 big-endian 32-bit words
+// - open() checks the bank bit of the drain status word, which pops nothing
+// - 32-bit wrap undone per call, so calls must come at least every 2^32
+//   edges of the busiest word (15 min at the 4.8 MHz maximum)
+// Build: g++ -O2 -std=c++11 -I../hal -c fpgaCounters.cpp (see ../hal/hal.mk)
+
+#include <cstdio>
+
+#include "fpgaCounters.h"
+
+std::mutex &fpgaSpiMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+FpgaCounters::FpgaCounters(unsigned csPin, uint8_t spiChannel) : _hal(hal()) {
+  _csPin      = csPin;
+  _spiChannel = spiChannel;
+  _primed     = false;
+  for (int i = 0; i < FPGA_BANK_WORDS; i++) _last[i] = 0;
+}
+
+bool FpgaCounters::open() {
+  if (!_hal.setup()) return false;
+  if (!_hal.spiSetup(_spiChannel, FPGA_SPI_HZ, 0)) {
+    std::perror("FPGA spiSetup");
+    return false;
+  }
+  _hal.pinMode(_csPin, HAL_OUTPUT);
+  _hal.digitalWrite(_csPin, 1);
+
+  // Command and status word only
+  uint8_t probe[5] = {FPGA_CMD_DRAIN};
+  int n;
+  {
+    std::lock_guard<std::mutex> guard(fpgaSpiMutex());
+    _hal.digitalWrite(_csPin, 0);
+    n = _hal.spiTransfer(_spiChannel, probe, sizeof(probe));
+    _hal.digitalWrite(_csPin, 1);
+  }
+  if (n != (int)sizeof(probe)) {
+    std::perror("FPGA spiTransfer");
+    return false;
+  }
+  uint32_t status = (uint32_t)probe[1] << 24 | (uint32_t)probe[2] << 16 | (uint32_t)probe[3] << 8 | probe[4];
+  if (status >> 30 != 3 || !(status & FPGA_STATUS_BANK)) {
+    std::fprintf(stderr, "No counter bank on the FPGA (status %08x), is the bitstream built with DEVICE=1k or 8k?\n", status);
+    return false;
+  }
+  return true;
+}
+
+bool FpgaCounters::transfer(uint8_t command, uint32_t bank[FPGA_BANK_WORDS]) {
+  uint8_t data[1 + 4 * FPGA_BANK_WORDS] = {command};
+  int n;
+  {
+    std::lock_guard<std::mutex> guard(fpgaSpiMutex());
+    _hal.digitalWrite(_csPin, 0);
+    n = _hal.spiTransfer(_spiChannel, data, sizeof(data));
+    _hal.digitalWrite(_csPin, 1);
+  }
+  if (n != (int)sizeof(data)) {
+    std::perror("FPGA spiTransfer");
+    return false;
+  }
+  for (int w = 0; w < FPGA_BANK_WORDS; w++) {
+    const uint8_t *p = &data[1 + 4 * w];
+    bank[w] = (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+  }
+  return true;
+}
+
+bool FpgaCounters::latch(uint32_t bank[FPGA_BANK_WORDS]) {
+  return transfer(FPGA_CMD_LATCH_READ, bank);
+}
+
+bool FpgaCounters::reread(uint32_t bank[FPGA_BANK_WORDS]) {
+  return transfer(FPGA_CMD_READ, bank);
+}
+
+bool FpgaCounters::deltas(const uint8_t *words, uint8_t n, uint64_t out[]) {
+  for (uint8_t i = 0; i < n; i++)
+    if (words[i] >= FPGA_BANK_WORDS) return false;
+
+  uint32_t now[FPGA_BANK_WORDS];
+  if (!latch(now)) return false;
+
+  for (uint8_t i = 0; i < n; i++)
+    out[i] = _primed ? (uint32_t)(now[words[i]] - _last[words[i]]) : 0;
+  for (int w = 0; w < FPGA_BANK_WORDS; w++) _last[w] = now[w];
+  _primed = true;
+  return true;
+}
@@ -0,0 +1,83 @@
+// Readout of the FPGA's latched counter bank (gateware latchedCounter.v and
+// counterSpi.v), and the loss accounting of the host's counts against it.
+//
+// The FPGA counts every rising edge of each raw channel and of its four
+// coincidence outputs (fpgaCoincidences.h) in 32 bits. One SPI transaction
+// latches all of them at once and reads the bank back, so a tick or a
+// window costs one burst however high the rate. Whatever the host counted
+// less than that, it missed.
+#ifndef __FPGACOUNTERS_H__
+#define __FPGACOUNTERS_H__
+
+#include <stdint.h>
+#include <mutex>
+
+#include "hal.h"
+
+#define FPGA_BANK_WORDS 8
+#ifndef FPGA_SPI_HZ
+#define FPGA_SPI_HZ 4000000    // counterSpi samples SCK with CLK, below CLK / 8 of the
+                               // 50 MHz rc.local sets; 1000000 for a 9.6 MHz CLK
+#endif
+#define FPGA_CS_PIN 24         // gpioSS, also the bitstream upload's CS
+
+#define FPGA_CMD_LATCH_READ 0x01
+#define FPGA_CMD_READ       0x02
+#define FPGA_CMD_DRAIN      0x03
+#define FPGA_STATUS_BANK    (1u << 28)   // drain status: the counter bank is there
+
+// Held around every transaction on the FPGA's SPI port, which the counter
+// bank and the hit FIFO share
+std::mutex &fpgaSpiMutex();
+
+class FpgaCounters {
+ public:
+  FpgaCounters(unsigned csPin = FPGA_CS_PIN, uint8_t spiChannel = 0);
+
+  // False unless the drain status word says the bitstream has the bank;
+  // the LP384 build reads zeros that would pass for a quiet window
+  bool open();
+
+  // Latch every counter and read the bank, or read the last latch again
+  bool latch(uint32_t bank[FPGA_BANK_WORDS]);
+  bool reread(uint32_t bank[FPGA_BANK_WORDS]);
+
+  // Edges on each bank word since the previous call (0 on the first call),
+  // false if the read failed, in which case out[] is not touched and the
+  // next call covers both
+  bool deltas(const uint8_t *words, uint8_t n, uint64_t out[]);
+
+ private:
+
+  bool transfer(uint8_t command, uint32_t bank[FPGA_BANK_WORDS]);
+
+  Hal &_hal;
+  unsigned _csPin;
+  uint8_t _spiChannel;
+  uint32_t _last[FPGA_BANK_WORDS];
+  bool _primed;
+};
+
+// Host count against the FPGA's for one channel and window. The host
+// counting more than the FPGA, or anything against an FPGA zero, is what a
+// missing or stuck bank looks like, so that window is not checked at all.
+struct LossEstimate {
+  bool checked;         // false: the counts disagree the wrong way, no estimate
+  double loss;          // fraction of edges the host missed
+  double correction;    // multiply the host count by this
+  double deadTime_s;    // non-paralysable dead time that explains the loss
+};
+
+inline LossEstimate estimateLoss(uint64_t host, uint64_t fpga, double live_s) {
+  LossEstimate e = {true, 0.0, 1.0, 0.0};
+  if (host > fpga) e.checked = false;
+  if (host >= fpga) return e;
+  e.loss = 1.0 - (double)host / fpga;
+  if (host == 0) return e;
+  // m = n / (1 + n tau) for measured rate m and true rate n
+  e.correction = (double)fpga / host;
+  e.deadTime_s = live_s > 0 ? e.loss * live_s / host : 0.0;
+  return e;
+}
+
+#endif //__FPGACOUNTERS_H__
@@ -0,0 +1,189 @@
+// fpgaHits.cpp — bulk SPI drain of the FPGA hit FIFO
+// - A 9-byte probe reads status, fill and tick, then one transaction of as
+//   many queued words as the fill says, up to FPGA_HIT_BURST
+// - The bus is shared with FpgaCounters, every transaction holds fpgaSpiMutex()
+//   and none holds it longer than one burst (8 ms at 4 MHz)
+// - Host time offset smoothed over 16 drains, so SPI latency jitter does not
+//   move hits of one drain against the next
+// - Width words share the epoch type, bit 29 set; the FPGA queues each one
+//   right after its hit, with at most epoch or overflow words between
+// Build: g++ -O2 -std=c++11 -I../hal -c fpgaHits.cpp (see ../hal/hal.mk)
+
+#include <cstdio>
+#include <mutex>
+
+#include <time.h>
+#include <unistd.h>
+
+#include "fpgaHits.h"
+#include "windowTimer.h"
+
+#define WORD_HIT      0
+#define WORD_EPOCH    1
+#define WORD_OVERFLOW 2
+#define WORD_STATUS   3
+
+#define STAMP_BITS 27
+#define EPOCH_SHIFT 25
+#define WIDTH_FLAG (1u << 29)           // epoch type: a width, not an epoch
+#define WIDTH_CHANNEL_SHIFT 27
+#define STATUS_WIDTHS (1u << 29)        // status: hits come with widths
+
+// Value with the given low bits nearest to ref
+static uint64_t unwrap(uint64_t ref, uint64_t low, unsigned bits) {
+  uint64_t span = 1ULL << bits;
+  uint64_t v = (ref & ~(span - 1)) | low;
+  if (ref > v && ref - v > span / 2) v += span;
+  else if (v > ref && v - ref > span / 2 && v >= span) v -= span;
+  return v;
+}
+
+static uint32_t wordAt(const uint8_t *p) {
+  return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+}
+
+FpgaHits::FpgaHits(unsigned csPin, uint8_t spiChannel) : _hal(hal()) {
+  _csPin      = csPin;
+  _spiChannel = spiChannel;
+  _anchored   = false;
+  _ref        = 0;
+  _synced     = false;
+  _offset_ns  = 0;
+  _widths     = false;
+  _cut        = 0;
+  _holding    = false;
+  _hits       = 0;
+  _cutHits    = 0;
+  _lost       = 0;
+  _unplaced   = 0;
+  _fill       = 0;
+  _periodMs   = 10;
+  _handler    = NULL;
+  _ctx        = NULL;
+  _running    = false;
+}
+
+FpgaHits::~FpgaHits() {
+  stop();
+}
+
+bool FpgaHits::open() {
+  if (!_hal.setup()) return false;
+  if (!_hal.spiSetup(_spiChannel, FPGA_SPI_HZ, 0)) {
+    std::perror("FPGA spiSetup");
+    return false;
+  }
+  _hal.pinMode(_csPin, HAL_OUTPUT);
+  _hal.digitalWrite(_csPin, 1);
+
+  // Status and tick only, pops nothing
+  uint8_t probe[9] = {FPGA_CMD_DRAIN};
+  if (!transfer(probe, sizeof(probe))) {
+    std::fprintf(stderr, "No hit FIFO on the FPGA, is the bitstream built with hitFifo.v?\n");
+    return false;
+  }
+  _widths = (wordAt(&probe[1]) & STATUS_WIDTHS) != 0;
+  return true;
+}
+
+bool FpgaHits::transfer(uint8_t *data, size_t length) {
+  int done;
+  {
+    std::lock_guard<std::mutex> guard(fpgaSpiMutex());
+    _hal.digitalWrite(_csPin, 0);
+    done = _hal.spiTransfer(_spiChannel, data, length);
+    _hal.digitalWrite(_csPin, 1);
+  }
+  return done == (int)length && wordAt(&data[1]) >> 30 == WORD_STATUS;
+}
+
+int FpgaHits::drain(FpgaHit *out, size_t max) {
+  size_t n = 0;
+  bool more = true;
+  while (more && n + FPGA_HIT_BURST <= max) {
+    // Status and tick alone first, so the burst is only as long as the queue
+    uint8_t probe[9] = {FPGA_CMD_DRAIN};
+    if (!transfer(probe, sizeof(probe))) return -1;
+    uint64_t after = clockNs(CLOCK_MONOTONIC);
+    _fill = wordAt(&probe[1]) & 0xFFFF;
+    uint32_t now = wordAt(&probe[5]);
+    size_t words = _fill < FPGA_HIT_BURST ? _fill : FPGA_HIT_BURST;
+    more = _fill > FPGA_HIT_BURST;
+
+    if (words) {
+      size_t length = 9 + 4 * words;
+      for (size_t i = 0; i < length; i++) _burst[i] = 0;
+      _burst[0] = FPGA_CMD_DRAIN;
+      if (!transfer(_burst, length)) return -1;
+    }
+    for (size_t w = 0; w < words; w++) {
+      uint32_t word = wordAt(&_burst[9 + 4 * w]);
+      uint32_t type = word >> 30;
+      if (type == WORD_STATUS) break;
+
+      if (type == WORD_EPOCH && (word & WIDTH_FLAG)) {
+        uint8_t channel = word >> WIDTH_CHANNEL_SHIFT & 3;
+        uint16_t width  = word & 0xFFFF;
+        _histogram.record(channel, width);
+        if (_holding && _held.channel == channel) {
+          _held.width = width;
+          _holding    = false;
+          if (width < _cut) _cutHits++;
+          else out[n++] = _held;
+        }
+      } else if (type == WORD_EPOCH) {
+        _ref = (uint64_t)(word & 0x1FFFFFFF) << EPOCH_SHIFT;
+        _anchored = true;
+      } else if (type == WORD_OVERFLOW) {
+        _lost += word & 0x3FFFFFFF;
+      } else if (!_anchored) {
+        _unplaced++;
+      } else {
+        _ref = unwrap(_ref, word & ((1u << STAMP_BITS) - 1), STAMP_BITS);
+        FpgaHit hit = {_ref, (uint8_t)(word >> STAMP_BITS & 7), 0};
+        _hits++;
+        if (_widths) {
+          // One whose width never came goes on without it
+          if (_holding) out[n++] = _held;
+          _held    = hit;
+          _holding = true;
+        } else {
+          out[n++] = hit;
+        }
+      }
+    }
+
+    // Tick at the probe's command against host time after the probe
+    if (_anchored) {
+      int64_t sample = (int64_t)after - (int64_t)(unwrap(_ref, now, 32) * FPGA_TICK_NS);
+      _offset_ns = _synced ? _offset_ns + (sample - _offset_ns) / 16 : sample;
+      _synced = true;
+    }
+  }
+  return (int)n;
+}
+
+bool FpgaHits::start(uint32_t periodMs, HitHandler handler, void *ctx) {
+  _periodMs = periodMs ? periodMs : 10;
+  _handler  = handler;
+  _ctx      = ctx;
+  _running  = true;
+  _thread = std::thread(&FpgaHits::run, this);
+  return true;
+}
+
+void FpgaHits::stop() {
+  _running = false;
+  if (_thread.joinable()) _thread.join();
+}
+
+void FpgaHits::run() {
+  bool failing = false;
+  while (_running) {
+    int n = drain(_batch, 4 * FPGA_HIT_BURST);
+    if ((n < 0) != failing) std::fprintf(stderr, n < 0 ? "FPGA hit FIFO drain failing\n" : "FPGA hit FIFO drain back\n");
+    failing = n < 0;
+    for (int i = 0; i < n; i++) _handler(_batch[i], monotonicNs(_batch[i].ticks), _ctx);
+    usleep(_periodMs * 1000);
+  }
+}
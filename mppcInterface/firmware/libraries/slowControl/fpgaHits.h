@@ -0,0 +1,114 @@
+// Drain of the FPGA's hit timestamp FIFO (gateware hitFifo.v).
+//
+// Every raw hit comes with a 27-bit stamp of the FPGA's tick counter; epoch
+// words every 2^25 ticks carry the top bits. Each stamp is rebuilt to the
+// full 54 bits as the value nearest the previous word, which the epoch
+// spacing makes unambiguous. Hits before the first epoch word cannot be
+// placed and are skipped.
+//
+// The tick at each drain command, against CLOCK_MONOTONIC right after the
+// transfer, gives a smoothed offset to host time; relative times between
+// hits keep the FPGA's 20 ns resolution.
+//
+// Bitstreams that say so in the status word follow every hit with its time
+// over threshold. A hit is then held until its width arrives, every width
+// goes into a per-channel histogram, and hits narrower than the cut (single
+// photon dark counts, mostly) are counted but never handed on.
+#ifndef __FPGAHITS_H__
+#define __FPGAHITS_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <thread>
+
+#include "fpgaCounters.h"
+#include "widthHistogram.h"
+
+#define FPGA_TICK_NS     20      // 50 MHz GPCLK
+#define FPGA_HIT_CHANNELS 4
+#define FPGA_HIT_BURST   1000    // words per transfer, inside spidev's 4 KiB buffer
+#define FPGA_WIDTH_MAX   0xFFFF  // saturated, that many ticks or more
+
+struct FpgaHit {
+  uint64_t ticks;        // since the FPGA was configured
+  uint8_t  channel;      // FPGA channel
+  uint16_t width;        // ticks over threshold, 0 if the bitstream sends none
+};
+
+class FpgaHits {
+ public:
+  // Called from the drain thread for every hit, with its host time
+  typedef void (*HitHandler)(const FpgaHit &hit, uint64_t monotonic_ns, void *ctx);
+
+  FpgaHits(unsigned csPin = FPGA_CS_PIN, uint8_t spiChannel = 0);
+  ~FpgaHits();
+
+  bool open();
+
+  // Empties the FIFO: a short read of its fill, then a burst of that many
+  // words, up to FPGA_HIT_BURST, until the fill is drained or max hits are
+  // out. An empty FIFO costs 9 bytes. Returns the number of hits, -1 if a transfer failed
+  // or the FPGA did not answer with a status word. With widths, the last
+  // hit may wait for its width until the next call.
+  int drain(FpgaHit *out, size_t max);
+
+  // Whether the bitstream sends widths, once open
+  bool widths() const { return _widths; }
+
+  // Hits narrower than ticks go to cut() instead of out; 0 passes all
+  void setCut(uint16_t ticks) { _cut = ticks; }
+
+  // Every width drained, hits below the cut included
+  WidthHistogram<FPGA_HIT_CHANNELS> &histogram() { return _histogram; }
+
+  // Drain every periodMs in a thread of its own
+  bool start(uint32_t periodMs, HitHandler handler, void *ctx);
+  void stop();
+
+  // CLOCK_MONOTONIC of an FPGA tick, once anchored
+  uint64_t monotonicNs(uint64_t ticks) const { return (uint64_t)((int64_t)(ticks * FPGA_TICK_NS) + _offset_ns); }
+
+  bool anchored() const { return _anchored; }
+  uint64_t hits() const { return _hits; }
+  uint64_t lost() const { return _lost; }           // dropped in the FPGA
+  uint64_t unplaced() const { return _unplaced; }   // before the first epoch
+  uint64_t cut() const { return _cutHits; }         // narrower than the cut
+  uint32_t fill() const { return _fill; }           // FIFO fill at the last drain
+
+ private:
+
+  void run();
+  bool transfer(uint8_t *data, size_t length);
+
+  Hal &_hal;
+  unsigned _csPin;
+  uint8_t _spiChannel;
+
+  bool _anchored;
+  uint64_t _ref;         // rebuilt tick of the last word
+  bool _synced;
+  int64_t _offset_ns;    // CLOCK_MONOTONIC - FPGA time
+  bool _widths;
+  uint16_t _cut;
+  bool _holding;         // _held waits for its width
+  FpgaHit _held;
+  WidthHistogram<FPGA_HIT_CHANNELS> _histogram;
+
+  volatile uint64_t _hits;
+  volatile uint64_t _lost;
+  volatile uint64_t _unplaced;
+  volatile uint64_t _cutHits;
+  volatile uint32_t _fill;
+
+  // Transfer and handler buffers, per instance so no two drains share one
+  uint8_t _burst[1 + 4 * (2 + FPGA_HIT_BURST)];
+  FpgaHit _batch[4 * FPGA_HIT_BURST];
+
+  std::thread _thread;
+  uint32_t _periodMs;
+  HitHandler _handler;
+  void *_ctx;
+  volatile bool _running;
+};
+
+#endif //__FPGAHITS_H__
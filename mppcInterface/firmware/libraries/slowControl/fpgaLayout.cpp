@@ -0,0 +1,28 @@
+// fpgaLayout.cpp — set or show the FPGA's coincidence layout
+// - With a config file: write it to the coincidence registers, read back
+// - Without: print the layout the FPGA holds, in the config syntax
+// - Run from rc.local once the FPGA is configured and its clock is up
+// Build: make fpgaLayout
+// Usage: ./fpgaLayout [coincidence.conf]
+
+#include <cstdio>
+
+#include "fpgaCoincidences.h"
+
+int main(int argc, char** argv) {
+  if (argc > 2) {
+    fprintf(stderr, "Usage: %s [coincidence.conf]\n", argv[0]);
+    return 1;
+  }
+
+  FpgaLayout layout;
+  if (argc == 2 && !loadFpgaLayout(argv[1], layout)) return 1;
+
+  FpgaCoincidences regs;
+  if (!regs.open()) return 1;
+  if (argc == 2 && !regs.write(layout)) return 1;
+  if (!regs.read(layout)) return 1;
+
+  printFpgaLayout(stdout, layout);
+  return 0;
+}
@@ -0,0 +1,54 @@
+// libgpiod v2 edge-event input for the slowControl counters.
+// Rising edges are read in batches from the GPIO character device, each one
+// carrying the kernel's CLOCK_MONOTONIC timestamp.
+#ifndef __GPIOEDGES_H__
+#define __GPIOEDGES_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "edgeDispatcher.h"
+
+struct gpiod_chip;
+struct gpiod_line_request;
+struct gpiod_edge_event_buffer;
+
+#define GPIOEDGES_MAX_CHANNELS 8
+
+class GpioEdges {
+ public:
+  // Called once per edge from the dispatcher thread
+  typedef void (*EdgeHandler)(uint8_t channel, uint64_t timestamp_ns);
+
+  // offsets are gpiochip line offsets (BCM numbers on a Pi), channel i = offsets[i]
+  GpioEdges(const char chipPath[], const unsigned int *offsets, uint8_t nChannels, EdgeHandler handler);
+  ~GpioEdges();
+
+  // Request the lines and register one fd per channel with the dispatcher
+  bool attach(EdgeDispatcher &dispatcher);
+
+  // Edges the kernel discarded because its event FIFO was full
+  uint64_t lost(uint8_t channel) const { return _lost[channel]; }
+
+ private:
+
+  static void onReady(void *ctx, uint32_t channel);
+
+  bool request(uint8_t channel);
+  void drain(uint8_t channel);
+
+  const char *_chipPath;
+  unsigned int _offsets[GPIOEDGES_MAX_CHANNELS];
+  uint8_t _nChannels;
+  EdgeHandler _handler;
+  EdgeDispatcher *_dispatcher;
+
+  struct gpiod_chip *_chip;
+  struct gpiod_line_request *_requests[GPIOEDGES_MAX_CHANNELS];
+  struct gpiod_edge_event_buffer *_buffer;
+
+  unsigned long _lastSeqno[GPIOEDGES_MAX_CHANNELS];
+  uint64_t _lost[GPIOEDGES_MAX_CHANNELS];
+};
+
+#endif //__GPIOEDGES_H__
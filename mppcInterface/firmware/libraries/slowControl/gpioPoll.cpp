@@ -0,0 +1,174 @@
+// gpioPoll.cpp — GPLEV0 busy-poll edge acquisition for slowControl
+// - One load of GPLEV0 per pass, edges of all channels from one AND-NOT
+// - The system timer is only read on a pass that found an edge
+// - Poll counts are published every 4096 passes to keep the loop store-free
+// Build: g++ -O2 -std=c++11 -c gpioPoll.cpp (link -lpthread)
+
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "gpioPoll.h"
+#include "windowTimer.h"
+
+static uint32_t readBe32(const uint8_t *p) {
+  return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+}
+
+uint32_t piPeripheralBase() {
+  // <child bus address> <parent address, 1 or 2 cells> <size>; the BCM2711
+  // has two address cells with the first one zero
+  FILE *ranges = fopen("/proc/device-tree/soc/ranges", "rb");
+  if (ranges) {
+    uint8_t buf[12];
+    size_t n = fread(buf, 1, sizeof(buf), ranges);
+    fclose(ranges);
+    if (n >= 8) {
+      uint32_t base = readBe32(buf + 4);
+      if (base == 0 && n >= 12) base = readBe32(buf + 8);
+      if (base) return base;
+    }
+  }
+
+  // New style revision codes carry the SoC in bits 12-15
+  FILE *cpuinfo = fopen("/proc/cpuinfo", "r");
+  unsigned rev = 0;
+  if (cpuinfo) {
+    char line[256];
+    while (fgets(line, sizeof(line), cpuinfo))
+      if (!strncasecmp(line, "revision", 8)) sscanf(strchr(line, ':') + 1, "%x", &rev);
+    fclose(cpuinfo);
+  }
+  if (rev & 0x800000) {
+    switch ((rev >> 12) & 0xF) {
+    case 0:  return 0x20000000;
+    case 1:
+    case 2:  return 0x3F000000;
+    default: return 0xFE000000;
+    }
+  }
+  return 0x20000000;
+}
+
+EdgeDetector::EdgeDetector(const unsigned int *offsets, uint8_t nChannels) {
+  _mask = 0;
+  _prev = 0;
+  std::memset(_channelOf, 0, sizeof(_channelOf));
+  for (uint8_t i = 0; i < nChannels && i < GPIOPOLL_MAX_CHANNELS; i++) {
+    if (offsets[i] > 31) continue;   // bank 1 is not polled
+    _mask |= 1u << offsets[i];
+    _channelOf[offsets[i]] = i;
+  }
+}
+
+GpioPoller::GpioPoller(const unsigned int *offsets, uint8_t nChannels, EdgeHandler handler)
+    : _detector(offsets, nChannels) {
+  _handler   = handler;
+  _gpio      = NULL;
+  _syst      = NULL;
+  _gpioMap   = MAP_FAILED;
+  _systMap   = MAP_FAILED;
+  _lastClo   = 0;
+  _systHigh  = 0;
+  _offset_ns = 0;
+  _polls     = 0;
+  _running   = false;
+}
+
+GpioPoller::~GpioPoller() {
+  stop();
+  if (_gpioMap != MAP_FAILED) munmap(_gpioMap, BCM_GPIO_LEN);
+  if (_systMap != MAP_FAILED) munmap(_systMap, BCM_SYST_LEN);
+}
+
+bool GpioPoller::mapHardware() {
+  int fd = open("/dev/gpiomem", O_RDWR | O_SYNC | O_CLOEXEC);
+  if (fd < 0) {
+    std::perror("/dev/gpiomem");
+    return false;
+  }
+  _gpioMap = mmap(NULL, BCM_GPIO_LEN, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (_gpioMap == MAP_FAILED) {
+    std::perror("mmap gpiomem");
+    return false;
+  }
+
+  // /dev/gpiomem only exposes the GPIO block, the timer needs /dev/mem
+  fd = open("/dev/mem", O_RDONLY | O_SYNC | O_CLOEXEC);
+  if (fd < 0) {
+    std::perror("/dev/mem (system timer, run as root)");
+    return false;
+  }
+  _systMap = mmap(NULL, BCM_SYST_LEN, PROT_READ, MAP_SHARED, fd, piPeripheralBase() + BCM_SYST_OFFSET);
+  close(fd);
+  if (_systMap == MAP_FAILED) {
+    std::perror("mmap system timer");
+    return false;
+  }
+
+  _gpio = static_cast<volatile uint32_t *>(_gpioMap);
+  _syst = static_cast<volatile uint32_t *>(_systMap);
+  return true;
+}
+
+void GpioPoller::mapMock(volatile uint32_t *gpio, volatile uint32_t *syst) {
+  _gpio = gpio;
+  _syst = syst;
+}
+
+bool GpioPoller::start(int cpu) {
+  if (!_gpio || !_syst) return false;
+
+  // Both clocks read back to back; the timer counts whole microseconds
+  uint32_t hi = _syst[BCM_SYST_CHI];
+  _lastClo    = _syst[BCM_SYST_CLO];
+  _systHigh   = (uint64_t)hi << 32;
+  _offset_ns  = (int64_t)clockNs(CLOCK_MONOTONIC) - (int64_t)(_systHigh | _lastClo) * 1000;
+  _detector.reset(_gpio[BCM_GPLEV0]);
+
+  _running = true;
+  _thread = std::thread(&GpioPoller::run, this);
+  if (cpu >= 0) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    int err = pthread_setaffinity_np(_thread.native_handle(), sizeof(set), &set);
+    if (err) std::fprintf(stderr, "Could not pin the poll thread to CPU %d: %s\n", cpu, strerror(err));
+  }
+  return true;
+}
+
+void GpioPoller::stop() {
+  _running = false;
+  if (_thread.joinable()) _thread.join();
+}
+
+// CLO wraps every 71 minutes, CHI is not read on the hot path
+inline uint64_t GpioPoller::systemTimer() {
+  uint32_t clo = _syst[BCM_SYST_CLO];
+  if (clo < _lastClo) _systHigh += 1ULL << 32;
+  _lastClo = clo;
+  return _systHigh | clo;
+}
+
+void GpioPoller::run() {
+  uint64_t polls = 0;
+  while (_running.load(std::memory_order_relaxed)) {
+    for (int i = 0; i < 4096; i++) {
+      uint32_t edges = _detector.rising(_gpio[BCM_GPLEV0]);
+      if (__builtin_expect(edges != 0, 0)) {
+        uint64_t t = (int64_t)(systemTimer() * 1000) + _offset_ns;
+        while (edges) _handler(_detector.next(edges), t);
+      }
+    }
+    polls += 4096;
+    _polls.store(polls, std::memory_order_relaxed);
+    systemTimer();   // keeps the wrap count right through quiet spells
+  }
+}
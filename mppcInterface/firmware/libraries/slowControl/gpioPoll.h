@@ -0,0 +1,106 @@
+// Busy-polling acquisition straight from the GPIO level register.
+//
+// A thread pinned to one core (ideally kept free with isolcpus=) reads
+// GPLEV0 in a tight loop and finds rising edges on every channel pin at once
+// with prev/level bit operations, so there is no interrupt or syscall per
+// edge. Edges are stamped from the BCM system timer (SYST_CLO/CHI, 1 MHz)
+// and handed out as ns aligned to CLOCK_MONOTONIC at start.
+//
+// The registers come either from /dev/gpiomem and /dev/mem on a Pi, or
+// from a plain memory block (mapMock) so the same loop runs on any Linux box.
+#ifndef __GPIOPOLL_H__
+#define __GPIOPOLL_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <thread>
+
+// Register word offsets, BCM2835 ARM Peripherals 6.1 and 12.1
+#define BCM_GPIO_OFFSET 0x200000
+#define BCM_SYST_OFFSET 0x003000
+#define BCM_GPIO_LEN    0xB4
+#define BCM_SYST_LEN    0x1C
+#define BCM_GPLEV0      13
+#define BCM_SYST_CLO    1
+#define BCM_SYST_CHI    2
+
+#define GPIOPOLL_MAX_CHANNELS 32
+
+// Peripheral base as the CPU sees it: 0x20000000 (BCM2835),
+// 0x3F000000 (BCM2836/7) or 0xFE000000 (BCM2711). Read from the device
+// tree, falls back to the revision code in /proc/cpuinfo.
+uint32_t piPeripheralBase();
+
+// Rising edge finder over one 32-bit level word
+class EdgeDetector {
+ public:
+  // offsets are GPIO numbers in bank 0, channel i = offsets[i]
+  EdgeDetector(const unsigned int *offsets, uint8_t nChannels);
+
+  // Bits of the channel pins that went 0 -> 1 since the last level
+  inline uint32_t rising(uint32_t level) {
+    uint32_t r = level & ~_prev & _mask;
+    _prev = level;
+    return r;
+  }
+
+  // Channel of the lowest set bit, which is cleared
+  inline uint8_t next(uint32_t &bits) const {
+    uint8_t channel = _channelOf[__builtin_ctz(bits)];
+    bits &= bits - 1;
+    return channel;
+  }
+
+  void reset(uint32_t level) { _prev = level; }
+  uint32_t mask() const { return _mask; }
+
+ private:
+  uint32_t _mask;
+  uint32_t _prev;
+  uint8_t _channelOf[32];
+};
+
+class GpioPoller {
+ public:
+  typedef void (*EdgeHandler)(uint8_t channel, uint64_t timestamp_ns);
+
+  GpioPoller(const unsigned int *offsets, uint8_t nChannels, EdgeHandler handler);
+  ~GpioPoller();
+
+  // GPIO from /dev/gpiomem, system timer from /dev/mem (needs root)
+  bool mapHardware();
+  // Any memory laid out like the GPIO and system timer blocks
+  void mapMock(volatile uint32_t *gpio, volatile uint32_t *syst);
+
+  // Poll on cpu (-1 = wherever the scheduler puts it)
+  bool start(int cpu);
+  void stop();
+
+  // GPLEV0 reads so far, each one is a sample of every channel
+  uint64_t polls() const { return _polls.load(std::memory_order_relaxed); }
+
+ private:
+
+  void run();
+  inline uint64_t systemTimer();
+
+  EdgeDetector _detector;
+  EdgeHandler _handler;
+
+  volatile uint32_t *_gpio;
+  volatile uint32_t *_syst;
+  void *_gpioMap;
+  void *_systMap;
+
+  // System timer extended to 64 bit, and its offset to CLOCK_MONOTONIC
+  uint32_t _lastClo;
+  uint64_t _systHigh;
+  int64_t _offset_ns;
+
+  std::atomic<uint64_t> _polls;
+  std::atomic<bool> _running;
+  std::thread _thread;
+};
+
+#endif //__GPIOPOLL_H__
@@ -0,0 +1,89 @@
+// HDR-style latency histogram, reported per window.
+//
+// Buckets are exact below 16 ns, then 16 per power of two (at most 6.25 %
+// wide) up to ~18 minutes, so one fixed array covers ns to minutes with
+// constant relative precision. record() is a relaxed atomic increment and
+// may be called from any thread; report() prints what arrived since the
+// previous report.
+#ifndef __LATENCYHISTOGRAM_H__
+#define __LATENCYHISTOGRAM_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+
+#define HIST_SUB_BITS 4
+#define HIST_BUCKETS  ((41 - HIST_SUB_BITS) << HIST_SUB_BITS)   // up to 2^40 ns
+
+class LatencyHistogram {
+ public:
+  LatencyHistogram() {
+    for (int i = 0; i < HIST_BUCKETS; i++) _counts[i] = 0;
+    _max = 0;
+    memset(_reported, 0, sizeof(_reported));
+  }
+
+  inline void record(uint64_t ns) {
+    unsigned b = bucket(ns);
+    _counts[b < HIST_BUCKETS ? b : HIST_BUCKETS - 1].fetch_add(1, std::memory_order_relaxed);
+    uint64_t m = _max.load(std::memory_order_relaxed);
+    while (ns > m && !_max.compare_exchange_weak(m, ns, std::memory_order_relaxed)) {}
+  }
+
+  // "[label] n, p50/p90/p99/p99.9 and max in us" since the previous call.
+  // Percentiles are bucket upper bounds capped at the max, so they never
+  // understate.
+  void report(FILE *out, const char label[]) {
+    uint64_t delta[HIST_BUCKETS];
+    uint64_t n = 0;
+    for (int i = 0; i < HIST_BUCKETS; i++) {
+      uint64_t c = _counts[i].load(std::memory_order_relaxed);
+      delta[i] = c - _reported[i];
+      _reported[i] = c;
+      n += delta[i];
+    }
+    uint64_t max = _max.exchange(0, std::memory_order_relaxed);
+    if (n == 0) {
+      fprintf(out, "[%s] 0 samples\n", label);
+      return;
+    }
+    fprintf(out, "[%s] %llu samples, p50 %.1f p90 %.1f p99 %.1f p99.9 %.1f max %.1f us\n",
+            label, (unsigned long long)n,
+            percentile(delta, n, 0.5, max) * 1e-3, percentile(delta, n, 0.9, max) * 1e-3,
+            percentile(delta, n, 0.99, max) * 1e-3, percentile(delta, n, 0.999, max) * 1e-3, max * 1e-3);
+  }
+
+  static inline unsigned bucket(uint64_t v) {
+    if (v < (1u << HIST_SUB_BITS)) return v;
+    unsigned shift = 63 - __builtin_clzll(v) - HIST_SUB_BITS;
+    return (shift << HIST_SUB_BITS) + (unsigned)(v >> shift);
+  }
+
+  // Smallest value of the next bucket
+  static inline uint64_t bucketEnd(unsigned b) {
+    if (b < (2u << HIST_SUB_BITS) - 1) return b + 1;
+    unsigned shift = (b >> HIST_SUB_BITS) - 1;
+    uint64_t mantissa = (b & ((1u << HIST_SUB_BITS) - 1)) | (1u << HIST_SUB_BITS);
+    return (mantissa + 1) << shift;
+  }
+
+ private:
+
+  static uint64_t percentile(const uint64_t *counts, uint64_t n, double q, uint64_t max) {
+    uint64_t rank = (uint64_t)(q * n + 0.5);
+    if (rank == 0) rank = 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < HIST_BUCKETS; i++) {
+      seen += counts[i];
+      if (seen >= rank) return bucketEnd(i) < max ? bucketEnd(i) : max;
+    }
+    return max;
+  }
+
+  std::atomic<uint64_t> _counts[HIST_BUCKETS];
+  std::atomic<uint64_t> _max;
+  uint64_t _reported[HIST_BUCKETS];   // reader side only
+};
+
+#endif //__LATENCYHISTOGRAM_H__
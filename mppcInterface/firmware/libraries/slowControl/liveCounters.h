@@ -0,0 +1,63 @@
+// Layout of the slowControl live counter segment in POSIX shared memory,
+// and the lock-free snapshot reader for C++ consumers.
+//
+// The segment is protected by a seqlock: seq is odd while slowControl writes
+// and is bumped by two per update. A reader copies the whole struct and
+// retries if seq was odd or changed under it. Readers never write to the
+// segment and never make a system call after mapping it.
+//
+// Every field is 8 bytes wide after the first four, so liveCounters.py can
+// unpack it with a flat struct format sized by the channels and levels
+// fields. Keep both in step.
+#ifndef __LIVECOUNTERS_H__
+#define __LIVECOUNTERS_H__
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+
+#include "logWriter.h"
+#include "rateAggregates.h"
+
+#define LIVE_MAGIC   0x4D505043   // "MPPC"
+#define LIVE_VERSION 1
+#define LIVE_SHM_NAME "/mppc_slowcontrol"
+
+struct LiveCounters {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t channels;          // LOG_CHANNELS
+  uint32_t levels;            // AGG_LEVELS
+
+  std::atomic<uint64_t> seq;
+  uint64_t updated_ns;        // CLOCK_REALTIME of this update
+
+  // Window in progress
+  uint64_t window_start_ns;
+  uint64_t window_live_ns;
+  uint64_t window_counts[LOG_CHANNELS];
+
+  // Last closed window, as written to the log
+  LogRecord last;
+
+  // Latest closed bin of every aggregate level, counts per live second
+  uint64_t rate_end_ns[AGG_LEVELS];
+  double   rate_hz[AGG_LEVELS][LOG_CHANNELS];
+};
+
+static_assert(sizeof(LiveCounters) == 16 + 8 * (4 + LOG_CHANNELS) + sizeof(LogRecord) + 8 * AGG_LEVELS * (1 + LOG_CHANNELS),
+              "liveCounters.py unpacks the segment without padding");
+
+// Consistent copy of the segment, false if the writer kept it busy
+inline bool readLiveCounters(const LiveCounters *shm, LiveCounters &out, int attempts = 1000) {
+  for (int i = 0; i < attempts; i++) {
+    uint64_t before = shm->seq.load(std::memory_order_acquire);
+    if (before & 1) continue;
+    memcpy(static_cast<void *>(&out), shm, sizeof(out));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (shm->seq.load(std::memory_order_relaxed) == before) return true;
+  }
+  return false;
+}
+
+#endif //__LIVECOUNTERS_H__
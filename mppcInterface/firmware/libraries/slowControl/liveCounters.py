@@ -0,0 +1,94 @@
+#!/usr/bin/env python3
+# liveCounters.py — Lock-free reader for slowControl's shared-memory live counters
+#
+# Usage:
+#   python3 liveCounters.py                      # print rates at 10 Hz
+#   python3 liveCounters.py /mppc_slowcontrol 1  # other segment, 1 Hz
+#
+# As a library:
+#   from liveCounters import LiveCounters
+#   live = LiveCounters()
+#   snap = live.snapshot()   # dict, consistent copy of the segment
+#
+# slowControl must run with -p <name>. Layout is LiveCounters in
+# liveCounters.h; the reader retries while the seqlock is odd or moves.
+
+import mmap
+import struct
+import sys
+import time
+
+SHM_NAME = "/mppc_slowcontrol"
+MAGIC = 0x4D505043
+VERSION = 1
+LEVEL_PERIODS = (1, 10, 60, 3600)
+HEADER = struct.Struct("<4I")
+SEQ_OFFSET = 16
+
+# magic, version, channels, levels, seq, updated, window start/live,
+# window counts, last record (start, end, live, counts, flags, reserved),
+# rate end times, rates. channels and levels come from the segment, so the
+# reader follows slowControl's channel map.
+def layout(channels, levels):
+    return struct.Struct("<4I4Q%dQ3Q%dQ2I%dQ%dd" % (channels, channels, levels, levels * channels))
+
+class LiveCounters:
+    def __init__(self, name=SHM_NAME):
+        with open("/dev/shm/" + name.lstrip("/"), "rb") as f:
+            self._map = mmap.mmap(f.fileno(), 0, prot=mmap.PROT_READ)
+        magic, version, self.channels, self.levels = HEADER.unpack_from(self._map, 0)
+        if magic != MAGIC or version != VERSION:
+            raise RuntimeError("%s is not a slowControl live counter segment" % name)
+        self._layout = layout(self.channels, self.levels)
+        if self._layout.size > len(self._map):
+            raise RuntimeError("%s is shorter than its header says" % name)
+
+    def _seq(self):
+        return struct.unpack_from("<Q", self._map, SEQ_OFFSET)[0]
+
+    def snapshot(self, attempts=1000):
+        """Consistent copy of the segment as a dict, None if it never settled."""
+        for _ in range(attempts):
+            before = self._seq()
+            if before & 1:
+                continue
+            raw = self._map[:self._layout.size]
+            if self._seq() == before:
+                return self._decode(self._layout.unpack(raw))
+        return None
+
+    def _decode(self, v):
+        CHANNELS, LEVELS = self.channels, self.levels
+        i = 8
+        window_counts = list(v[i:i + CHANNELS]); i += CHANNELS
+        last_start, last_end, last_live = v[i:i + 3]; i += 3
+        last_counts = list(v[i:i + CHANNELS]); i += CHANNELS
+        last_flags = v[i]; i += 2
+        rate_end = list(v[i:i + LEVELS]); i += LEVELS
+        rates = [list(v[i + l * CHANNELS:i + (l + 1) * CHANNELS]) for l in range(LEVELS)]
+        return {
+            "updated_ns": v[5],
+            "window_start_ns": v[6],
+            "window_live_ns": v[7],
+            "window_counts": window_counts,
+            "last": {"start_ns": last_start, "end_ns": last_end, "live_ns": last_live,
+                     "counts": last_counts, "flags": last_flags},
+            "rate_end_ns": rate_end,
+            "rate_hz": rates,
+        }
+
+def main():
+    name = sys.argv[1] if len(sys.argv) > 1 else SHM_NAME
+    hz = float(sys.argv[2]) if len(sys.argv) > 2 else 10.0
+    live = LiveCounters(name)
+    while True:
+        snap = live.snapshot()
+        if snap:
+            live_s = snap["window_live_ns"] * 1e-9
+            counts = " ".join("%8d" % c for c in snap["window_counts"])
+            rates = " ".join("%8.2f" % r for r in snap["rate_hz"][1])
+            print("window %6.1f s | %s | 10s Hz %s" % (live_s, counts, rates), flush=True)
+        time.sleep(1.0 / hz)
+
+if __name__ == "__main__":
+    main()
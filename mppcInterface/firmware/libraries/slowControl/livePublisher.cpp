@@ -0,0 +1,149 @@
+// livePublisher.cpp — seqlock writer for the live counter segment
+// - shm_open + ftruncate + mmap once, then plain stores
+// - Window in progress = counts up to the last tick + active bank peek
+// - Stale segments from a previous run are replaced, not reused
+// Build: g++ -O2 -std=c++11 -c livePublisher.cpp (link -lrt -lpthread)
+
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "livePublisher.h"
+#include "windowTimer.h"
+
+LivePublisher::LivePublisher(CounterBank<LOG_CHANNELS> &counters) : _counters(counters) {
+  _shm           = NULL;
+  _name[0]       = 0;
+  _windowStart   = 0;
+  _baseLive      = 0;
+  _liveStartMono = 0;
+  _periodMs      = 100;
+  _running       = false;
+  std::memset(_baseCounts, 0, sizeof(_baseCounts));
+}
+
+LivePublisher::~LivePublisher() {
+  stop();
+  if (_shm) {
+    munmap(_shm, sizeof(LiveCounters));
+    shm_unlink(_name);
+  }
+}
+
+bool LivePublisher::open(const char name[], uint64_t windowStart_ns, uint64_t liveStart_mono) {
+  std::snprintf(_name, sizeof(_name), "%s", name);
+  shm_unlink(_name);
+  int fd = shm_open(_name, O_RDWR | O_CREAT | O_EXCL, 0644);
+  if (fd < 0) {
+    std::perror("shm_open");
+    return false;
+  }
+  if (ftruncate(fd, sizeof(LiveCounters)) < 0) {
+    std::perror("ftruncate shm");
+    close(fd);
+    return false;
+  }
+  void *map = mmap(NULL, sizeof(LiveCounters), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    std::perror("mmap shm");
+    return false;
+  }
+
+  _shm = static_cast<LiveCounters *>(map);
+  std::memset(static_cast<void *>(_shm), 0, sizeof(LiveCounters));
+  _shm->magic    = LIVE_MAGIC;
+  _shm->version  = LIVE_VERSION;
+  _shm->channels = LOG_CHANNELS;
+  _shm->levels   = AGG_LEVELS;
+
+  _windowStart   = windowStart_ns;
+  _liveStartMono = liveStart_mono;
+  return true;
+}
+
+bool LivePublisher::start(uint32_t periodMs) {
+  if (!_shm) return false;
+  _periodMs = periodMs ? periodMs : 100;
+  _running = true;
+  _thread = std::thread(&LivePublisher::run, this);
+  return true;
+}
+
+void LivePublisher::stop() {
+  _running = false;
+  if (_thread.joinable()) _thread.join();
+}
+
+void LivePublisher::run() {
+  while (_running) {
+    {
+      std::lock_guard<std::mutex> guard(_mutex);
+      publishCurrent();
+    }
+    usleep(_periodMs * 1000);
+  }
+}
+
+void LivePublisher::beginTick() {
+  if (_shm) _mutex.lock();
+}
+
+void LivePublisher::endTick(uint64_t tickEnd_ns, const uint64_t counts[LOG_CHANNELS],
+                            uint64_t tickLive_ns, uint64_t liveStart_mono, bool windowClosed) {
+  if (!_shm) return;
+  if (windowClosed) {
+    _windowStart = tickEnd_ns;
+    _baseLive = 0;
+    std::memset(_baseCounts, 0, sizeof(_baseCounts));
+  } else {
+    _baseLive += tickLive_ns;
+    for (size_t i = 0; i < LOG_CHANNELS; i++) _baseCounts[i] += counts[i];
+  }
+  _liveStartMono = liveStart_mono;
+  publishCurrent();
+  _mutex.unlock();
+}
+
+void LivePublisher::publishWindow(const LogRecord &record, const RateAggregates &aggregates) {
+  if (!_shm) return;
+  AggBin latest[AGG_LEVELS];
+  bool have[AGG_LEVELS];
+  for (int l = 0; l < AGG_LEVELS; l++) have[l] = aggregates.latest(l, &latest[l], 1) == 1;
+
+  std::lock_guard<std::mutex> guard(_mutex);
+  writeBegin();
+  _shm->last = record;
+  for (int l = 0; l < AGG_LEVELS; l++) {
+    if (!have[l]) continue;
+    double live = latest[l].live_ns * 1e-9;
+    _shm->rate_end_ns[l] = latest[l].end_ns;
+    for (size_t i = 0; i < LOG_CHANNELS; i++)
+      _shm->rate_hz[l][i] = live > 0 ? latest[l].counts[i] / live : 0.0;
+  }
+  writeEnd();
+}
+
+// Caller holds _mutex
+void LivePublisher::publishCurrent() {
+  uint64_t now = clockNs(CLOCK_MONOTONIC);
+  writeBegin();
+  _shm->window_start_ns = _windowStart;
+  _shm->window_live_ns  = _baseLive + (now - _liveStartMono);
+  for (size_t i = 0; i < LOG_CHANNELS; i++)
+    _shm->window_counts[i] = _baseCounts[i] + _counters.peek(i);
+  writeEnd();
+}
+
+void LivePublisher::writeBegin() {
+  _shm->seq.store(_shm->seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+}
+
+void LivePublisher::writeEnd() {
+  _shm->updated_ns = clockNs(CLOCK_REALTIME);
+  _shm->seq.store(_shm->seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
@@ -0,0 +1,58 @@
+// Publishes slowControl's live counters to POSIX shared memory (liveCounters.h).
+//
+// A publisher thread refreshes the window in progress every periodMs from
+// the active counter bank. The main loop reports each 1 s tick and each
+// closed window. Both writers are serialised by a mutex that the counting
+// path never touches; readers are lock-free.
+#ifndef __LIVEPUBLISHER_H__
+#define __LIVEPUBLISHER_H__
+
+#include <stdint.h>
+#include <mutex>
+#include <thread>
+
+#include "counterBank.h"
+#include "liveCounters.h"
+
+class LivePublisher {
+ public:
+  LivePublisher(CounterBank<LOG_CHANNELS> &counters);
+  ~LivePublisher();
+
+  bool open(const char name[], uint64_t windowStart_ns, uint64_t liveStart_mono);
+  bool start(uint32_t periodMs);
+  void stop();
+
+  // Main loop, around the 1 s counter rollover. The rollover goes between
+  // the two calls so the publisher thread never sees a half-moved count.
+  void beginTick();
+  void endTick(uint64_t tickEnd_ns, const uint64_t counts[LOG_CHANNELS],
+               uint64_t tickLive_ns, uint64_t liveStart_mono, bool windowClosed);
+
+  // Main loop, after a window has been logged
+  void publishWindow(const LogRecord &record, const RateAggregates &aggregates);
+
+ private:
+
+  void run();
+  void publishCurrent();
+  void writeBegin();
+  void writeEnd();
+
+  CounterBank<LOG_CHANNELS> &_counters;
+  LiveCounters *_shm;
+  char _name[64];
+
+  // Window so far as of the last tick, guarded by _mutex
+  uint64_t _windowStart;
+  uint64_t _baseLive;
+  uint64_t _baseCounts[LOG_CHANNELS];
+  uint64_t _liveStartMono;
+
+  std::mutex _mutex;
+  std::thread _thread;
+  uint32_t _periodMs;
+  volatile bool _running;
+};
+
+#endif //__LIVEPUBLISHER_H__
@@ -0,0 +1,504 @@
+// loadBench.cpp — highest edge rate the counting path sustains without loss
+// - Synthetic trains on every channel: Poisson, bursty or periodic
+// - Rate per channel swept up geometrically, each step counted/injected
+// - isr: a woken thread per channel, edges arriving while one is pending
+//   merge into it, as with wiringPiISR on the sysfs value file
+// - epoll: per-channel event FIFO of the kernel's depth, drained by the
+//   EdgeDispatcher thread, as with -g
+// - gpiosim: real gpio-sim lines pulled through sysfs, read by GpioEdges
+//   (make GPIOD=1, needs root)
+// - Knee = first rate where counted/injected < threshold; CPU of the whole
+//   process and of the counting threads alone; CSV and/or JSON report
+// Build: make loadBench
+// Usage: ./loadBench -h
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <random>
+#include <thread>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+
+#include "channelMap.h"
+#include "counterBank.h"
+#include "edgeDispatcher.h"
+#include "windowTimer.h"
+#ifdef HAVE_GPIOD
+#include "gpioEdges.h"
+#endif
+
+#define CHANNELS ((int)CHANNEL_COUNT)
+#define FIFO_DEPTH 16        // gpiolib-cdev default, events per line
+#define SPIN_NS 200000       // closer than this the generator spins instead of sleeping
+#define MAX_STEPS 64
+
+static CounterBank<CHANNELS> counters;
+
+enum Pattern { PATTERN_POISSON, PATTERN_BURST, PATTERN_PERIODIC };
+static const char *patternNames[] = {"poisson", "burst", "periodic"};
+
+struct TrainConfig {
+  Pattern  pattern;
+  double   rate_hz;        // mean, per channel
+  uint32_t burstLen;       // edges per burst
+  uint64_t burstGap_ns;    // spacing inside a burst
+};
+
+struct Step {
+  double   rate_hz;        // asked for, per channel
+  double   achieved_hz;    // injected per channel per second
+  uint64_t injected;
+  uint64_t counted;
+  double   ratio;
+  double   cpu_pct;        // whole process, one core = 100
+  double   path_pct;       // counting threads only
+};
+
+// Gaps between the edges of one channel
+class EdgeTrain {
+ public:
+  EdgeTrain(const TrainConfig &config, uint64_t seed) : _config(config), _rng(seed), _left(0) {}
+
+  uint64_t gap() {
+    switch (_config.pattern) {
+      case PATTERN_PERIODIC:
+        return (uint64_t)(1e9 / _config.rate_hz);
+      case PATTERN_BURST:
+        if (_left) {
+          _left--;
+          return _config.burstGap_ns;
+        }
+        _left = _config.burstLen - 1;
+        return exponential(_config.rate_hz / _config.burstLen);
+      default:
+        return exponential(_config.rate_hz);
+    }
+  }
+
+ private:
+  uint64_t exponential(double rate_hz) {
+    return (uint64_t)(std::exponential_distribution<double>(rate_hz)(_rng) * 1e9);
+  }
+
+  TrainConfig _config;
+  std::mt19937_64 _rng;
+  uint32_t _left;
+};
+
+static double threadCpu(pthread_t thread) {
+  clockid_t id;
+  if (pthread_getcpuclockid(thread, &id) != 0) return 0;
+  return clockNs(id) * 1e-9;
+}
+
+static double processCpu() {
+  struct rusage ru;
+  getrusage(RUSAGE_SELF, &ru);
+  return ru.ru_utime.tv_sec + ru.ru_utime.tv_usec * 1e-6 +
+         ru.ru_stime.tv_sec + ru.ru_stime.tv_usec * 1e-6;
+}
+
+// wiringPiISR model: the kernel latches one pending edge per line and wakes
+// the line's thread, which clears it before calling the handler
+class IsrModel {
+ public:
+  IsrModel(uint8_t n) : _n(n), _running(false) {}
+
+  bool start() {
+    _running = true;
+    for (uint8_t c = 0; c < _n; c++) {
+      _pending[c].store(false);
+      _fd[c] = eventfd(0, EFD_CLOEXEC);
+      if (_fd[c] < 0) {
+        std::perror("eventfd");
+        return false;
+      }
+      _threads[c] = std::thread(&IsrModel::run, this, c);
+    }
+    return true;
+  }
+
+  inline void inject(uint8_t c) {
+    if (_pending[c].exchange(true, std::memory_order_acq_rel)) return;
+    uint64_t one = 1;
+    if (write(_fd[c], &one, sizeof(one)) < 0) std::perror("eventfd write");
+  }
+
+  double pathCpu() {
+    double s = 0;
+    for (uint8_t c = 0; c < _n; c++) s += threadCpu(_threads[c].native_handle());
+    return s;
+  }
+
+  void stop() {
+    _running = false;
+    for (uint8_t c = 0; c < _n; c++) {
+      uint64_t one = 1;
+      if (write(_fd[c], &one, sizeof(one)) < 0) std::perror("eventfd write");
+      _threads[c].join();
+      close(_fd[c]);
+    }
+  }
+
+  const char *name() const { return "isr"; }
+
+ private:
+  void run(uint8_t c) {
+    uint64_t value;
+    while (read(_fd[c], &value, sizeof(value)) == sizeof(value) && _running) {
+      _pending[c].store(false, std::memory_order_release);
+      counters.increment(c);
+    }
+  }
+
+  uint8_t _n;
+  volatile bool _running;
+  std::atomic<bool> _pending[CHANNELS];
+  int _fd[CHANNELS];
+  std::thread _threads[CHANNELS];
+};
+
+// -g model: every edge is queued in a bounded per-line FIFO and the line fd
+// turns readable; the dispatcher drains all ready lines per wakeup. Edges
+// that find the FIFO full are dropped, as the kernel does.
+class EpollModel {
+ public:
+  EpollModel(uint8_t n) : _n(n) {}
+
+  bool start() {
+    for (uint8_t c = 0; c < _n; c++) {
+      _fifo[c].head.store(0);
+      _fifo[c].tail.store(0);
+      _fifo[c].fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+      if (_fifo[c].fd < 0 || !_dispatcher.add(_fifo[c].fd, &EpollModel::onReady, this, c)) return false;
+    }
+    return _dispatcher.start();
+  }
+
+  inline void inject(uint8_t c) {
+    Fifo &f = _fifo[c];
+    uint32_t tail = f.tail.load(std::memory_order_relaxed);
+    if (tail - f.head.load(std::memory_order_acquire) == FIFO_DEPTH) return;
+    f.tail.store(tail + 1, std::memory_order_release);
+    uint64_t one = 1;
+    if (write(f.fd, &one, sizeof(one)) < 0) std::perror("eventfd write");
+  }
+
+  double pathCpu() { return threadCpu(_dispatcher.handle()); }
+
+  void stop() {
+    _dispatcher.stop();
+    for (uint8_t c = 0; c < _n; c++) close(_fifo[c].fd);
+  }
+
+  const char *name() const { return "epoll"; }
+
+ private:
+  struct Fifo {
+    std::atomic<uint32_t> head;
+    std::atomic<uint32_t> tail;
+    int fd;
+  };
+
+  static void onReady(void *ctx, uint32_t c) {
+    Fifo &f = static_cast<EpollModel *>(ctx)->_fifo[c];
+    uint64_t value;
+    if (read(f.fd, &value, sizeof(value)) < 0) return;
+    uint32_t head = f.head.load(std::memory_order_relaxed);
+    uint32_t tail = f.tail.load(std::memory_order_acquire);
+    for (; head != tail; head++) counters.increment(c);
+    f.head.store(head, std::memory_order_release);
+  }
+
+  uint8_t _n;
+  Fifo _fifo[CHANNELS];
+  EdgeDispatcher _dispatcher;
+};
+
+#ifdef HAVE_GPIOD
+// Real kernel path: each injected edge pulls a gpio-sim line down and up
+// through sysfs, GpioEdges reads it back exactly as main does with -g
+class GpioSimModel {
+ public:
+  GpioSimModel(uint8_t n, const char chip[], const char simDir[])
+    : _n(n), _simDir(simDir), _edges(chip, channelOffsets(), n, &GpioSimModel::onEdge) {}
+
+  bool start() {
+    char path[256];
+    for (uint8_t c = 0; c < _n; c++) {
+      std::snprintf(path, sizeof(path), "%s/sim_gpio%u/pull", _simDir, CHANNEL_MAP[c].bcm);
+      _pull[c] = open(path, O_WRONLY | O_CLOEXEC);
+      if (_pull[c] < 0) {
+        std::perror(path);
+        return false;
+      }
+      pull(c, false);
+    }
+    if (!_edges.attach(_dispatcher)) return false;
+    return _dispatcher.start();
+  }
+
+  inline void inject(uint8_t c) {
+    pull(c, false);
+    pull(c, true);
+  }
+
+  double pathCpu() { return threadCpu(_dispatcher.handle()); }
+
+  void stop() {
+    _dispatcher.stop();
+    for (uint8_t c = 0; c < _n; c++) close(_pull[c]);
+  }
+
+  const char *name() const { return "gpiosim"; }
+
+ private:
+  static void onEdge(uint8_t channel, uint64_t) { counters.increment(channel); }
+
+  void pull(uint8_t c, bool up) {
+    const char *value = up ? "pull-up" : "pull-down";
+    if (pwrite(_pull[c], value, std::strlen(value), 0) < 0) std::perror("sim pull");
+  }
+
+  uint8_t _n;
+  const char *_simDir;
+  int _pull[CHANNELS];
+  EdgeDispatcher _dispatcher;
+  GpioEdges _edges;
+};
+#endif
+
+// Counts still arriving after the trains stop, until two reads agree
+static uint64_t settle() {
+  uint64_t last = ~0ULL;
+  for (int i = 0; i < 200; i++) {
+    uint64_t sum = 0;
+    for (int c = 0; c < CHANNELS; c++) sum += counters.peek(c);
+    if (sum == last) break;
+    last = sum;
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  uint64_t window[CHANNELS];
+  uint64_t total = 0;
+  for (int r = 0; r < 2; r++) {
+    counters.rollover(window);
+    for (int c = 0; c < CHANNELS; c++) total += window[c];
+  }
+  return total;
+}
+
+template <class Model>
+static Step runStep(Model &model, uint8_t n, const TrainConfig &config, double seconds, uint64_t seed) {
+  settle();   // anything left from the previous step
+
+  EdgeTrain *trains[CHANNELS];
+  uint64_t next[CHANNELS];
+  uint64_t start = clockNs(CLOCK_MONOTONIC);
+  for (uint8_t c = 0; c < n; c++) {
+    trains[c] = new EdgeTrain(config, seed * CHANNELS + c);
+    next[c] = start + trains[c]->gap();   // random phase for periodic trains too
+    if (config.pattern == PATTERN_PERIODIC) next[c] = start + (uint64_t)(1e9 / config.rate_hz * c / n);
+  }
+  uint64_t end = start + (uint64_t)(seconds * 1e9);
+
+  double cpu0  = processCpu();
+  double path0 = model.pathCpu();
+  uint64_t injected = 0;
+
+  while (1) {
+    uint8_t c = 0;
+    for (uint8_t i = 1; i < n; i++)
+      if (next[i] < next[c]) c = i;
+    if (next[c] >= end) break;
+
+    uint64_t now;
+    while ((now = clockNs(CLOCK_MONOTONIC)) < next[c]) {
+      if (next[c] - now > SPIN_NS) {
+        struct timespec ts = {0, (long)(next[c] - now - SPIN_NS / 2)};
+        nanosleep(&ts, NULL);
+      } else {
+        std::this_thread::yield();
+      }
+    }
+    model.inject(c);
+    injected++;
+    next[c] += trains[c]->gap();
+  }
+
+  uint64_t elapsed = clockNs(CLOCK_MONOTONIC) - start;
+  Step step;
+  step.rate_hz     = config.rate_hz;
+  step.injected    = injected;
+  step.counted     = settle();
+  step.achieved_hz = injected / (elapsed * 1e-9) / n;
+  step.ratio       = injected ? (double)step.counted / injected : 1.0;
+  step.cpu_pct     = 100.0 * (processCpu() - cpu0) / (elapsed * 1e-9);
+  step.path_pct    = 100.0 * (model.pathCpu() - path0) / (elapsed * 1e-9);
+
+  for (uint8_t c = 0; c < n; c++) delete trains[c];
+  return step;
+}
+
+static void writeCsv(FILE *out, const Step *steps, int nSteps) {
+  fprintf(out, "rate_hz,achieved_hz,injected,counted,ratio,cpu_pct,path_cpu_pct\n");
+  for (int i = 0; i < nSteps; i++)
+    fprintf(out, "%.1f,%.1f,%llu,%llu,%.6f,%.2f,%.2f\n", steps[i].rate_hz, steps[i].achieved_hz,
+            (unsigned long long)steps[i].injected, (unsigned long long)steps[i].counted,
+            steps[i].ratio, steps[i].cpu_pct, steps[i].path_pct);
+}
+
+static void writeJson(FILE *out, const char model[], const TrainConfig &config, uint8_t n,
+                      double threshold, int knee, const Step *steps, int nSteps) {
+  fprintf(out, "{\n  \"model\": \"%s\",\n  \"pattern\": \"%s\",\n  \"channels\": %u,\n",
+          model, patternNames[config.pattern], n);
+  if (config.pattern == PATTERN_BURST)
+    fprintf(out, "  \"burst_len\": %u,\n  \"burst_gap_ns\": %llu,\n", config.burstLen,
+            (unsigned long long)config.burstGap_ns);
+  fprintf(out, "  \"threshold\": %.6f,\n", threshold);
+  // Highest rate that still passed, null if the first step failed or none did
+  if (knee > 0) fprintf(out, "  \"knee_hz\": %.1f,\n", steps[knee - 1].achieved_hz);
+  else fprintf(out, "  \"knee_hz\": null,\n");
+  fprintf(out, "  \"steps\": [\n");
+  for (int i = 0; i < nSteps; i++)
+    fprintf(out, "    {\"rate_hz\": %.1f, \"achieved_hz\": %.1f, \"injected\": %llu, \"counted\": %llu, "
+            "\"ratio\": %.6f, \"cpu_pct\": %.2f, \"path_cpu_pct\": %.2f}%s\n",
+            steps[i].rate_hz, steps[i].achieved_hz, (unsigned long long)steps[i].injected,
+            (unsigned long long)steps[i].counted, steps[i].ratio, steps[i].cpu_pct,
+            steps[i].path_pct, i + 1 < nSteps ? "," : "");
+  fprintf(out, "  ]\n}\n");
+}
+
+template <class Model>
+static int sweep(Model &model, uint8_t n, TrainConfig config, double from, double to, double factor,
+                 double seconds, double threshold, bool all, const char csvName[], const char jsonName[]) {
+  if (!model.start()) return 1;
+
+  Step steps[MAX_STEPS];
+  int nSteps = 0;
+  int knee   = -1;   // index of the first failing step
+  printf("%-6s %-8s %12s %12s %12s %12s %9s %7s %7s\n", "model", "pattern", "rate/ch Hz",
+         "achieved Hz", "injected", "counted", "ratio %", "cpu %", "path %");
+  for (double rate = from; rate <= to * 1.000001 && nSteps < MAX_STEPS; rate *= factor) {
+    config.rate_hz = rate;
+    Step &s = steps[nSteps] = runStep(model, n, config, seconds, nSteps + 1);
+    nSteps++;
+    printf("%-6s %-8s %12.1f %12.1f %12llu %12llu %9.3f %7.1f %7.1f\n", model.name(),
+           patternNames[config.pattern], s.rate_hz, s.achieved_hz, (unsigned long long)s.injected,
+           (unsigned long long)s.counted, 100.0 * s.ratio, s.cpu_pct, s.path_pct);
+    fflush(stdout);
+    if (s.ratio < threshold && knee < 0) {
+      knee = nSteps - 1;
+      if (!all) break;
+    }
+  }
+  model.stop();
+
+  if (knee < 0) printf("no knee up to %.1f Hz per channel\n", steps[nSteps - 1].achieved_hz);
+  else if (knee == 0) printf("knee below %.1f Hz per channel\n", steps[0].achieved_hz);
+  else printf("knee: %.1f Hz per channel (%.1f Hz total), %.3f %% at %.1f Hz\n",
+              steps[knee - 1].achieved_hz, steps[knee - 1].achieved_hz * n,
+              100.0 * steps[knee].ratio, steps[knee].achieved_hz);
+
+  if (csvName) {
+    FILE *f = fopen(csvName, "w");
+    if (!f) { perror(csvName); return 1; }
+    writeCsv(f, steps, nSteps);
+    fclose(f);
+  }
+  if (jsonName) {
+    FILE *f = fopen(jsonName, "w");
+    if (!f) { perror(jsonName); return 1; }
+    writeJson(f, model.name(), config, n, threshold, knee < 0 ? nSteps : knee, steps, nSteps);
+    fclose(f);
+  }
+  return 0;
+}
+
+static void usage(const char name[]) {
+  fprintf(stderr,
+          "Usage: %s [-m isr|epoll|gpiosim] [-p poisson|burst|periodic] [-r from,to,factor]\n"
+          "          [-t seconds] [-n channels] [-b burst_len] [-g burst_gap_ns] [-q threshold]\n"
+          "          [-a] [-c /dev/gpiochipN -s /sys/.../gpiochipN] [-o report.csv] [-j report.json]\n",
+          name);
+}
+
+int main(int argc, char** argv) {
+  const char *modelName = "isr";
+#ifdef HAVE_GPIOD
+  const char *chip      = NULL;
+  const char *simDir    = NULL;
+#endif
+  const char *csvName   = NULL;
+  const char *jsonName  = NULL;
+  TrainConfig config    = {PATTERN_POISSON, 0, 10, 1000};
+  double from = 100, to = 1e6, factor = 2;
+  double seconds   = 2;
+  double threshold = 0.999;
+  int n    = CHANNELS;
+  bool all = false;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "m:p:r:t:n:b:g:q:ac:s:o:j:h")) != -1) {
+    switch (opt) {
+      case 'm': modelName = optarg; break;
+      case 'p':
+        if      (!strcmp(optarg, "poisson"))  config.pattern = PATTERN_POISSON;
+        else if (!strcmp(optarg, "burst"))    config.pattern = PATTERN_BURST;
+        else if (!strcmp(optarg, "periodic")) config.pattern = PATTERN_PERIODIC;
+        else { usage(argv[0]); return 1; }
+        break;
+      case 'r':
+        if (sscanf(optarg, "%lf,%lf,%lf", &from, &to, &factor) < 2) { usage(argv[0]); return 1; }
+        break;
+      case 't': seconds            = atof(optarg); break;
+      case 'n': n                  = atoi(optarg); break;
+      case 'b': config.burstLen    = atoi(optarg); break;
+      case 'g': config.burstGap_ns = strtoull(optarg, NULL, 10); break;
+      case 'q': threshold          = atof(optarg); break;
+      case 'a': all                = true; break;
+#ifdef HAVE_GPIOD
+      case 'c': chip               = optarg; break;
+      case 's': simDir             = optarg; break;
+#endif
+      case 'o': csvName            = optarg; break;
+      case 'j': jsonName           = optarg; break;
+      default:  usage(argv[0]); return 1;
+    }
+  }
+  if (n < 1 || n > CHANNELS || from <= 0 || to < from || factor <= 1 || seconds <= 0 ||
+      config.burstLen < 1) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  if (!strcmp(modelName, "isr")) {
+    IsrModel model(n);
+    return sweep(model, n, config, from, to, factor, seconds, threshold, all, csvName, jsonName);
+  }
+  if (!strcmp(modelName, "epoll")) {
+    EpollModel model(n);
+    return sweep(model, n, config, from, to, factor, seconds, threshold, all, csvName, jsonName);
+  }
+  if (!strcmp(modelName, "gpiosim")) {
+#ifdef HAVE_GPIOD
+    if (!chip || !simDir) {
+      fprintf(stderr, "gpiosim needs -c /dev/gpiochipN and -s <sysfs dir of the chip>\n");
+      return 1;
+    }
+    GpioSimModel model(n, chip, simDir);
+    return sweep(model, n, config, from, to, factor, seconds, threshold, all, csvName, jsonName);
+#else
+    fprintf(stderr, "gpiosim is built with 'make GPIOD=1 loadBench'\n");
+    return 1;
+#endif
+  }
+  usage(argv[0]);
+  return 1;
+}
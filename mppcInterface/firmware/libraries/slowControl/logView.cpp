@@ -0,0 +1,80 @@
+// logView.cpp — text view of a slowControl log, binary or text
+// Binary logs (written with main -B) are rendered in the classic line
+// format, text logs are passed through. -f keeps following like tail -f,
+// -H first prints the column names from the channel map.
+// Build: make logView
+// Usage: ./logView [-f] [-H] <log_file>
+
+#include <cstdio>
+#include <cstring>
+
+#include <unistd.h>
+
+#include "logWriter.h"
+
+static void passThrough(FILE *in) {
+  char chunk[4096];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof(chunk), in)) > 0) fwrite(chunk, 1, n, stdout);
+}
+
+// Whole records only, a record still being written is picked up next time
+static void renderRecords(FILE *in) {
+  LogRecord record;
+  char line[320];
+  long pos = ftell(in);
+  while (fread(&record, sizeof(record), 1, in) == 1) {
+    formatLogText(record, line, sizeof(line));
+    fputs(line, stdout);
+    pos = ftell(in);
+  }
+  fseek(in, pos, SEEK_SET);
+}
+
+int main(int argc, char** argv) {
+  bool follow = false;
+  bool header = false;
+  int opt;
+  while ((opt = getopt(argc, argv, "fH")) != -1) {
+    if (opt == 'f') follow = true;
+    if (opt == 'H') header = true;
+  }
+  if (optind >= argc) {
+    fprintf(stderr, "Usage: %s [-f] [-H] <log_file>\n", argv[0]);
+    return 1;
+  }
+
+  FILE *in = fopen(argv[optind], "rb");
+  if (!in) {
+    perror(argv[optind]);
+    return 1;
+  }
+
+  LogFileHeader fileHeader;
+  bool binary = fread(&fileHeader, sizeof(fileHeader), 1, in) == 1 &&
+                memcmp(fileHeader.magic, LOG_FILE_MAGIC, sizeof(fileHeader.magic)) == 0;
+  if (binary && (fileHeader.recordSize != sizeof(LogRecord) || fileHeader.channels != LOG_CHANNELS)) {
+    fprintf(stderr, "Log has %u channels in %u byte records, this build %u in %zu\n",
+            fileHeader.channels, fileHeader.recordSize, (unsigned)LOG_CHANNELS, sizeof(LogRecord));
+    return 1;
+  }
+  if (!binary) rewind(in);
+
+  if (header) {
+    char line[320];
+    formatLogHeader(line, sizeof(line));
+    fputs(line, stdout);
+  }
+
+  while (1) {
+    if (binary) renderRecords(in);
+    else passThrough(in);
+    fflush(stdout);
+    if (!follow) break;
+    clearerr(in);
+    sleep(1);
+  }
+
+  fclose(in);
+  return 0;
+}
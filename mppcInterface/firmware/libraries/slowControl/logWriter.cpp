@@ -0,0 +1,126 @@
+// logWriter.cpp — group-committed window log for slowControl
+// - One open() for the life of the process instead of one per window
+// - Records formatted straight into a buffer sized at open time
+// - One write() per commitEvery records, fdatasync every syncEvery commits
+//   (0 leaves syncing to the kernel), so SD cards see few, larger writes
+// Build: g++ -O2 -std=c++11 -c logWriter.cpp
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "logWriter.h"
+
+// Longest text line: 10 x 20 digits, separators and asctime
+#define TEXT_LINE_MAX 320
+
+size_t formatLogText(const LogRecord &record, char *out, size_t size) {
+  time_t end = record.end_ns / 1000000000ULL;
+  struct tm timeinfo;
+  char when[32];
+  localtime_r(&end, &timeinfo);
+  asctime_r(&timeinfo, when);
+
+  size_t used = 0;
+  for (size_t i = 0; i < LOG_CHANNELS && used < size; i++)
+    used += std::snprintf(out + used, size - used, "%llu, ", (unsigned long long)record.counts[i]);
+  if (used < size)
+    used += std::snprintf(out + used, size - used, "%llu, %llu, %llu, %s",
+                          (unsigned long long)record.start_ns, (unsigned long long)record.end_ns,
+                          (unsigned long long)record.live_ns, when);
+  return used < size ? used : size - 1;
+}
+
+size_t formatLogHeader(char *out, size_t size) {
+  size_t used = std::snprintf(out, size, "# ");
+  for (size_t i = 0; i < LOG_CHANNELS && used < size; i++)
+    used += std::snprintf(out + used, size - used, "%s, ", CHANNEL_MAP[i].name);
+  if (used < size) used += std::snprintf(out + used, size - used, "start_ns, end_ns, live_ns, time\n");
+  return used < size ? used : size - 1;
+}
+
+LogWriter::LogWriter(bool binary, uint32_t commitEvery, uint32_t syncEvery) {
+  _binary      = binary;
+  _commitEvery = commitEvery ? commitEvery : 1;
+  _syncEvery   = syncEvery;
+  _pending     = 0;
+  _commits     = 0;
+  _fd          = -1;
+  _used        = 0;
+  _capacity    = (size_t)_commitEvery * (binary ? sizeof(LogRecord) : TEXT_LINE_MAX);
+  _buffer      = new char[_capacity];
+}
+
+LogWriter::~LogWriter() {
+  if (_fd >= 0) {
+    commit(true);
+    close(_fd);
+  }
+  delete[] _buffer;
+}
+
+bool LogWriter::open(const char filename[]) {
+  _fd = ::open(filename, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+  if (_fd < 0) {
+    std::perror("open log file");
+    return false;
+  }
+
+  // New binary files start with a header, appends to an existing one do not
+  struct stat st;
+  if (_binary && fstat(_fd, &st) == 0 && st.st_size == 0) {
+    LogFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, LOG_FILE_MAGIC, sizeof(header.magic));
+    header.recordSize = sizeof(LogRecord);
+    header.channels   = LOG_CHANNELS;
+    if (!writeAll(reinterpret_cast<const char *>(&header), sizeof(header))) return false;
+  }
+  return true;
+}
+
+bool LogWriter::append(const LogRecord &record) {
+  if (_binary) {
+    std::memcpy(_buffer + _used, &record, sizeof(record));
+    _used += sizeof(record);
+  } else {
+    _used += formatLogText(record, _buffer + _used, _capacity - _used);
+  }
+
+  if (++_pending < _commitEvery) return true;
+  return commit(_syncEvery && (_commits + 1) % _syncEvery == 0);
+}
+
+bool LogWriter::commit(bool sync) {
+  bool ok = true;
+  if (_used) {
+    ok = writeAll(_buffer, _used);
+    _used = 0;
+    _pending = 0;
+    _commits++;
+  }
+  if (sync && fdatasync(_fd) < 0) {
+    std::perror("fdatasync log file");
+    ok = false;
+  }
+  return ok;
+}
+
+bool LogWriter::writeAll(const char *data, size_t length) {
+  while (length > 0) {
+    ssize_t n = write(_fd, data, length);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      std::perror("write log file");
+      return false;
+    }
+    data += n;
+    length -= n;
+  }
+  return true;
+}
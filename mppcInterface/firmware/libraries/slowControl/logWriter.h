@@ -0,0 +1,76 @@
+// Persistent-handle window log writer for slowControl.
+//
+// The file stays open for the life of the process. Records are encoded into a
+// preallocated buffer (no per-record heap allocation), written in groups of
+// commitEvery records and fdatasync'd every syncEvery commits.
+//
+// Text mode keeps the classic line format. Binary mode writes a LogFileHeader
+// followed by fixed-size LogRecords; logView turns those back into text.
+#ifndef __LOGWRITER_H__
+#define __LOGWRITER_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "channelMap.h"
+
+#define LOG_FILE_MAGIC "MPPCLG01"
+#define LOG_CHANNELS CHANNEL_COUNT
+
+// LogRecord flags
+#define LOG_FLAG_PARTIAL      0x01  // window shorter than nominal (start-up)
+#define LOG_FLAG_KERNEL_LOST  0x02  // kernel dropped edges during the window
+#define LOG_FLAG_RING_OVERRUN 0x04  // event stream dropped edges
+#define LOG_FLAG_HOST_LOSS    0x08  // host counted fewer edges than the FPGA (-F)
+#define LOG_FLAG_RECOVERED    0x10  // counts carried over from a run that died (-J)
+#define LOG_FLAG_UART_GAP     0x20  // telemetry frames missed or corrupt (-U)
+
+struct LogFileHeader {
+  char     magic[8];     // LOG_FILE_MAGIC, not terminated
+  uint32_t recordSize;   // sizeof(LogRecord)
+  uint32_t channels;     // LOG_CHANNELS
+};
+
+struct LogRecord {
+  uint64_t start_ns;     // window start, ns since the epoch
+  uint64_t end_ns;       // window end, ns since the epoch
+  uint64_t live_ns;      // measured counting time
+  uint64_t counts[LOG_CHANNELS];
+  uint32_t flags;
+  uint32_t reserved;
+};
+
+// Classic text line for a record, "c0, ..., c6, start, end, live, asctime"
+size_t formatLogText(const LogRecord &record, char *out, size_t size);
+
+// Column names of that line from the channel map, "# CH0&&CH1, ..., asctime"
+size_t formatLogHeader(char *out, size_t size);
+
+class LogWriter {
+ public:
+  LogWriter(bool binary, uint32_t commitEvery, uint32_t syncEvery);
+  ~LogWriter();
+
+  bool open(const char filename[]);
+  bool append(const LogRecord &record);
+
+  // Write out pending records now, fdatasync if sync is set
+  bool commit(bool sync);
+
+ private:
+
+  bool writeAll(const char *data, size_t length);
+
+  bool _binary;
+  uint32_t _commitEvery;
+  uint32_t _syncEvery;
+  uint32_t _pending;
+  uint32_t _commits;
+
+  int _fd;
+  char *_buffer;
+  size_t _used;
+  size_t _capacity;
+};
+
+#endif //__LOGWRITER_H__
@@ -1,78 +1,647 @@
 #include <stdio.h>
 #include <stdlib.h>
-#include <wiringPi.h>
 #include <iostream>
-#include <fstream>
 #include <time.h>
+#include <unistd.h>
+
+#include "counterBank.h"
+#include "channelMap.h"
+#include "checkpoint.h"
+#include "edgeDispatcher.h"
+#include "countStore.h"
+#include "eventRing.h"
+#include "eventWriter.h"
+#include "fpgaCoincidences.h"
+#include "fpgaCounters.h"
+#include "fpgaHits.h"
+#include "gpioPoll.h"
+#include "hal.h"
+#include "latencyHistogram.h"
+#include "livePublisher.h"
+#include "logWriter.h"
+#include "procStats.h"
+#include "rateAggregates.h"
+#include "realtime.h"
+#include "telemetry.h"
+#include "windowTimer.h"
+#ifdef HAVE_GPIOD
+#include "gpioEdges.h"
+#include "coincidence.h"
+#include "hitReorder.h"
+#include <mutex>
+#endif
 
 using namespace std;
 
-static volatile int counters[7] = {0};
+// One counter per channel map row (channelMap.h), in its order
+static CounterBank<CHANNEL_COUNT> counters;
+
+// Missed-edge accounting (-F): every input against the FPGA bank word
+// counting the same channels. Fabric counting (-f) takes the counts from
+// the bank instead of from edges, telemetry (-U) from the FPGA's UART
+// frames of the same bank.
+#define LOSS_FLAG_FRACTION 1e-3   // loss that flags the window
+static uint8_t lossHost[CHANNEL_MAX];
+static uint8_t lossWord[CHANNEL_MAX];
+static uint8_t lossChannels = 0;
+static uint8_t fabricWord[CHANNEL_MAX];
+void telemetryCounts(const uint64_t deltas[TELEMETRY_WORDS], uint16_t seq, void* ctx);
+
+// FPGA hit timestamps (-T), drained in bulk into their own event file.
+// Their pulse widths are histogrammed per window (-H), and hits narrower
+// than the cut (-t) are dropped before the event file.
+static EdgeRing hitRing;
+void fpgaHit(const FpgaHit& hit, uint64_t monotonic_ns, void* ctx);
+void writeWidths(FILE* out, uint64_t windowEnd, FpgaHits& hits);
+
+void pollEdge(uint8_t channel, uint64_t timestamp_ns);
+
+// Latency profile (-L, implied by -R): kernel edge stamp to handler, and
+// 1 s timer expiry to the main loop waking up
+static LatencyHistogram edgeLatency;
+static LatencyHistogram tickJitter;
+static volatile bool latencyMode = false;
+
+#ifdef HAVE_GPIOD
+void kernelEdge(uint8_t channel, uint64_t timestamp_ns);
+
+// Event mode (-e): every edge also goes to the binary event file
+static EdgeRing eventRing;
+static volatile bool eventMode = false;
 
-// Prototypes
-void interrupt0(void); // CH0 && CH1
-void interrupt1(void); // CH0 && CH2
-void interrupt2(void); // CH1 && CH2
-void interrupt3(void); // CH0 && CH1 && CH2
-void interrupt4(void); // CH0 raw
-void interrupt5(void); // CH1 raw
-void interrupt6(void); // CH2 raw
+// Software coincidences with accidental estimates (-D): the FPGA's
+// combinations rebuilt from the raw inputs, numbered by FPGA channel
+static CoincidenceEngine coincEngine;
+static HitReorder coincReorder(coincEngine, 10000000);   // 10 ms, above any batch delay
+static std::mutex coincMutex;
+static volatile bool coincMode = false;
+#endif
+
+// Edge handlers, one instance per channel map row. edge() is for the
+// interrupt backends, timed() for the timestamped ones; the role checks
+// are constants, so each instance compiles down to its own work only.
+template <size_t I>
+struct ChannelEdge {
+    static void edge(void) { counters.increment(I); }
+
+    static void timed(uint64_t timestamp_ns) {
+        counters.increment(I);
+#ifdef HAVE_GPIOD
+        if (eventMode) eventRing.push(I, timestamp_ns);
+        if (channelIsRaw(I) && coincMode) {
+            std::lock_guard<std::mutex> guard(coincMutex);
+            coincReorder.push(channelFpga(I), timestamp_ns);
+        }
+#else
+        (void)timestamp_ns;
+#endif
+    }
+};
+typedef ChannelHandlers<ChannelEdge> Handlers;
 
 int main(int argc, char** argv) {
-    if (argc < 2) {
-        cout << "Usage: " << argv[0] << " <output_filename>" << endl;
+    const char* gpioChip = NULL;
+    const char* eventFile = NULL;
+    const char* aggregatePrefix = NULL;
+    uint32_t windowSec = 60;
+    const char* storeFile = NULL;
+    const char* shmName = NULL;
+    const char* coincDelays = NULL;
+    const char* lossFile = NULL;
+    const char* journalFile = NULL;
+    const char* hitFile = NULL;
+    const char* uartDevice = NULL;
+    const char* widthFile = NULL;
+    uint32_t widthCut = 0;      // ns, 0 = every hit
+    const char* coincWindow = NULL;   // ns, default 2000 covers kernel timestamp jitter
+    int pollCpu = -1;
+    bool pollMode = false;
+    bool fabricMode = false;
+    int rtPriority = 0;         // 0 = normal scheduling
+    int rtCpu = -1;
+    bool binaryLog = false;
+    uint32_t commitEvery = 1;   // windows per write()
+    uint32_t syncEvery = 60;    // writes per fdatasync, 0 = never
+    uint32_t journalSync = 5;   // checkpoints per msync
+    int opt;
+    while ((opt = getopt(argc, argv, "g:e:w:a:BC:S:s:p:D:k:P:R:LF:J:K:fT:U:H:t:")) != -1) {
+        switch (opt) {
+        case 'g': gpioChip = optarg; break;
+        case 'e': eventFile = optarg; break;
+        case 'w': windowSec = strtoul(optarg, NULL, 10); break;
+        case 'a': aggregatePrefix = optarg; break;
+        case 'B': binaryLog = true; break;
+        case 'C': commitEvery = strtoul(optarg, NULL, 10); break;
+        case 'S': syncEvery = strtoul(optarg, NULL, 10); break;
+        case 's': storeFile = optarg; break;
+        case 'p': shmName = optarg; break;
+        case 'D': coincDelays = optarg; break;
+        case 'k': coincWindow = optarg; break;
+        case 'P': pollCpu = atoi(optarg); pollMode = true; break;
+        case 'R': sscanf(optarg, "%d,%d", &rtPriority, &rtCpu); latencyMode = true; break;
+        case 'L': latencyMode = true; break;
+        case 'F': lossFile = optarg; break;
+        case 'J': journalFile = optarg; break;
+        case 'K': journalSync = strtoul(optarg, NULL, 10); break;
+        case 'f': fabricMode = true; break;
+        case 'T': hitFile = optarg; break;
+        case 'U': uartDevice = optarg; break;
+        case 'H': widthFile = optarg; break;
+        case 't': widthCut = strtoul(optarg, NULL, 10); break;
+        default:  optind = argc; break;
+        }
+    }
+    if (optind >= argc || windowSec == 0) {
+        cout << "Usage: " << argv[0] << " [-w seconds] [-a aggregate_prefix] [-B] [-C commit_every] [-S sync_every] [-s store] [-p /shm_name] [-R priority[,cpu]] [-L] [-F losses.csv] [-J journal [-K sync_every]] [-g /dev/gpiochipN | -P cpu | -f | -U /dev/ttyN] [-e events.bin] [-T fpga_hits.bin [-H widths.csv] [-t cut_ns]] [-k window_ns -D delay_ns,...] <output_filename>" << endl;
+        return 1;
+    }
+    const char* outputFile = argv[optind];
+
+    // Before any thread exists, so every stack is locked and faulted in
+    if (rtPriority && !rtLockMemory()) cerr << "Running without locked memory" << endl;
+
+    LogWriter output(binaryLog, commitEvery, syncEvery);
+    if (!output.open(outputFile)) return 1;
+
+    // Columnar copy of every window for fast range scans (-s)
+    CountStoreWriter store;
+    if (storeFile && !store.open(storeFile)) return 1;
+
+    // FPGA counter bank, for missed-edge accounting (-F) or as the counts (-f)
+    FpgaCounters fpga;
+    FILE* losses = NULL;
+    uint64_t fpgaTick[CHANNEL_MAX];
+    uint64_t fpgaSnapshot[CHANNEL_MAX] = {0};
+    bool fpgaValid = true;   // every tick of the window was read
+
+    // Bank words 4-7 count whatever the coincidence registers say
+    FpgaLayout layout = fpgaDefaultLayout();
+    if (fabricMode || uartDevice || lossFile) {
+        FpgaCoincidences coincRegs;
+        if (!coincRegs.open() || !coincRegs.read(layout)) {
+            cerr << "Assuming the fixed coincidence layout" << endl;
+            layout = fpgaDefaultLayout();
+        }
+    }
+    if (fabricMode || uartDevice) {
+        if (lossFile || gpioChip || pollMode || eventFile || coincDelays || (fabricMode && uartDevice)) {
+            cerr << "-f and -U count in the FPGA, they take none of -F, -g, -P, -e, -D or each other" << endl;
+            return 1;
+        }
+        for (size_t i = 0; i < CHANNEL_COUNT; i++) {
+            int word = fpgaBankWord(CHANNEL_MAP[i].fpgaMask, layout);
+            if (word < 0) {
+                cerr << "The FPGA bank has no counter for " << CHANNEL_MAP[i].name << endl;
+                return 1;
+            }
+            fabricWord[i] = word;
+        }
+        if (fabricMode && (!fpga.open() || !fpga.deltas(fabricWord, CHANNEL_COUNT, fpgaTick))) return 1;
+    }
+    if (lossFile) {
+        for (size_t i = 0; i < CHANNEL_COUNT; i++) {
+            int word = fpgaBankWord(CHANNEL_MAP[i].fpgaMask, layout);
+            if (word < 0) continue;
+            lossHost[lossChannels] = i;
+            lossWord[lossChannels++] = word;
+        }
+        if (!fpga.open() || !fpga.deltas(lossWord, lossChannels, fpgaTick)) return 1;
+        losses = fopen(lossFile, "a");
+        if (!losses) {
+            perror(lossFile);
+            return 1;
+        }
+        if (ftell(losses) == 0) fprintf(losses, "end_ns,live_ns,counter,host,fpga,loss,correction,dead_time_ns\n");
+    }
+
+    // FPGA hit timestamps (-T), next to any input model
+    EventWriter hitWriter(hitRing, FPGA_HIT_CHANNELS);
+    FpgaHits hits;
+    uint64_t hitsLost    = 0;
+    uint64_t hitOverruns = 0;
+    FILE* widths = NULL;
+    if ((widthFile || widthCut) && !hitFile) {
+        cerr << "-H and -t work on the FPGA hits, use them with -T" << endl;
+        return 1;
+    }
+    if (hitFile && !hits.open()) return 1;
+    if ((widthFile || widthCut) && !hits.widths()) {
+        cerr << "The FPGA sends no pulse widths, is the bitstream built with the current hitFifo.v?" << endl;
+        return 1;
+    }
+    hits.setCut(min<uint32_t>((widthCut + FPGA_TICK_NS - 1) / FPGA_TICK_NS, FPGA_WIDTH_MAX));
+    if (widthFile) {
+        widths = fopen(widthFile, "a");
+        if (!widths) {
+            perror(widthFile);
+            return 1;
+        }
+        if (ftell(widths) == 0) {
+            fprintf(widths, "end_ns,channel");
+            for (unsigned b = 0; b < WIDTH_BUCKETS; b++)
+                fprintf(widths, ",%u", WidthHistogram<FPGA_HIT_CHANNELS>::bucketStart(b) * FPGA_TICK_NS);
+            fprintf(widths, "\n");
+        }
+    }
+    if (hitFile && (!hitWriter.open(hitFile) || !hits.start(10, &fpgaHit, NULL))) return 1;
+
+    EdgeDispatcher dispatcher;
+    TelemetryReader* telemetry = NULL;
+    uint64_t uartMissed = 0;
+    uint64_t uartErrors = 0;
+    uint64_t uartFrames = 0;
+    uint64_t uartHangups = 0;
+#ifdef HAVE_GPIOD
+    GpioEdges* edges = NULL;
+    EventWriter writer(eventRing, CHANNEL_COUNT);
+#endif
+
+    GpioPoller* poller = NULL;
+
+    if ((eventFile || coincDelays) && !gpioChip && !pollMode) {
+        cerr << "Event mode and -D need edge timestamps, use them with -g or -P" << endl;
+        return 1;
+    }
+
+#ifdef HAVE_GPIOD
+    // Timestamped edges from either -g or -P
+    if (eventFile) {
+        if (!writer.open(eventFile)) return 1;
+        eventMode = true;
+    }
+    if (coincDelays) {
+        uint64_t window_ns = coincWindow ? strtoull(coincWindow, NULL, 10) : 2000;
+        for (size_t i = 0; i < CHANNEL_COUNT; i++) {
+            if (!channelIsCoincidence(i)) continue;
+            CoincidenceDef def;
+            snprintf(def.name, sizeof(def.name), "%s", CHANNEL_MAP[i].name);
+            def.mask      = CHANNEL_MAP[i].fpgaMask;
+            def.k         = channelBits(def.mask);
+            def.window_ns = window_ns;
+            coincEngine.add(def);
+        }
+        for (const char* p = coincDelays; *p;) {
+            char* end;
+            uint64_t delay = strtoull(p, &end, 10);
+            if (end == p || !coincEngine.addDelay(delay)) {
+                cerr << "Bad delay list " << coincDelays << endl;
+                return 1;
+            }
+            p = *end == ',' ? end + 1 : end;
+        }
+        coincMode = true;
+    }
+#else
+    if (eventFile || coincDelays || coincWindow) {
+        cerr << "Event mode, -D and -k are built with 'make GPIOD=1'" << endl;
+        return 1;
+    }
+#endif
+
+    if (fabricMode) {
+        // Counted in the FPGA, one bank read per tick below, no edge path
+    } else if (uartDevice) {
+        // Counted in the FPGA, a frame a second on the UART added to the
+        // counters as it arrives, so it lands in the tick it is read in
+        telemetry = new TelemetryReader(uartDevice, &telemetryCounts, NULL);
+        if (!telemetry->attach(dispatcher) || !dispatcher.start()) return 1;
+        if (rtPriority) rtSetThread(dispatcher.handle(), rtPriority, rtCpu);
+    } else if (pollMode) {
+        // Busy-poll GPLEV0 on a core of its own (isolcpus=), no interrupts
+        poller = new GpioPoller(channelOffsets(), CHANNEL_COUNT, &pollEdge);
+        if (!poller->mapHardware() || !poller->start(pollCpu)) return 1;
+    } else if (gpioChip) {
+#ifdef HAVE_GPIOD
+        // Character device backend, all seven line fds in one epoll thread.
+        // Needs no wiringPi, so it also runs against a gpio-sim chip.
+        edges = new GpioEdges(gpioChip, channelOffsets(), CHANNEL_COUNT, &kernelEdge);
+        if (!edges->attach(dispatcher) || !dispatcher.start()) return 1;
+        if (rtPriority) rtSetThread(dispatcher.handle(), rtPriority, rtCpu);
+#else
+        cerr << "Built without libgpiod, rebuild with 'make GPIOD=1'" << endl;
         return 1;
+#endif
+    } else {
+        // HAL edge handlers, wiringPiISR threads in the default build
+        if (!hal().setup()) return 1;
+        for (size_t i = 0; i < CHANNEL_COUNT; i++) {
+            if (!hal().onRisingEdge(CHANNEL_MAP[i].bcm, Handlers::edges()[i])) {
+                cerr << "Cannot watch GPIO" << CHANNEL_MAP[i].bcm << endl;
+                return 1;
+            }
+        }
     }
 
-    time_t rawtime;
-    struct tm* timeinfo;
-    ofstream output;
+    // CPU and context switch cost of the input model, printed every window
+    ProcStats stats;
+
+    // 1 s ticks on whole seconds of wall time feed the rolling aggregates.
+    // Log windows close on exact multiples of windowSec; the first one is
+    // partial and starts now, its live time says how partial.
+    RateAggregates aggregates;
+    if (aggregatePrefix && !aggregates.openStreams(aggregatePrefix)) return 1;
+    WindowTimer ticks(1);
+    if (!ticks.start()) return 1;
+    const uint64_t windowNs = (uint64_t)windowSec * 1000000000ULL;
+    uint64_t tickStart   = clockNs(CLOCK_REALTIME);
+    uint64_t windowStart = tickStart;
+    uint64_t liveStart   = clockNs(CLOCK_MONOTONIC);
+    uint64_t snapshot[CHANNEL_COUNT] = {0};
+    uint64_t liveTime    = 0;
+    uint32_t windowFlags = 0;
+
+    // Window in progress journalled every tick (-J). A window the previous
+    // run died in is carried on if this one starts inside it, otherwise
+    // logged on its own up to its last checkpoint. Either way its live time
+    // leaves out the restart gap.
+    CheckpointJournal journal(journalSync);
+    if (journalFile) {
+        CheckpointSlot last;
+        bool recovered;
+        if (!journal.open(journalFile, last, recovered)) return 1;
+        uint64_t lastWindowEnd = (last.start_ns / windowNs + 1) * windowNs;
+        if (recovered && last.tickEnd_ns <= tickStart && tickStart < lastWindowEnd) {
+            windowStart = last.start_ns;
+            for (size_t i = 0; i < CHANNEL_COUNT; i++) snapshot[i] = last.counts[i];
+            liveTime    = last.live_ns;
+            windowFlags = last.flags | LOG_FLAG_RECOVERED;
+            fpgaValid   = false;   // the FPGA deltas only cover this run
+            fprintf(stderr, "[journal] continuing the window from %llu, %.1f s live\n",
+                    (unsigned long long)last.start_ns, last.live_ns * 1e-9);
+        } else if (recovered) {
+            LogRecord record;
+            record.start_ns = last.start_ns;
+            record.end_ns   = last.tickEnd_ns;
+            record.live_ns  = last.live_ns;
+            for (size_t i = 0; i < CHANNEL_COUNT; i++) record.counts[i] = last.counts[i];
+            record.flags    = last.flags | LOG_FLAG_PARTIAL | LOG_FLAG_RECOVERED;
+            record.reserved = 0;
+            output.append(record);
+            // On disk before the save below overwrites it
+            if (!output.commit(true)) return 1;
+            if (storeFile) store.append(record);
+            char line[320];
+            formatLogText(record, line, sizeof(line));
+            fputs(line, stdout);
+            fprintf(stderr, "[journal] logged the unfinished window from %llu, %.1f s live\n",
+                    (unsigned long long)last.start_ns, last.live_ns * 1e-9);
+        }
+        journal.save(windowStart, tickStart, liveTime, snapshot, windowFlags);
+        journal.sync();
+    }
 
-    wiringPiSetup();
+    // Live counters in shared memory for local consumers (-p)
+    LivePublisher publisher(counters);
+    if (shmName && (!publisher.open(shmName, windowStart, liveStart) || !publisher.start(100))) return 1;
+#ifdef HAVE_GPIOD
+    uint64_t kernelLost   = 0;
+    uint64_t ringOverruns = 0;
+    uint64_t coincOn[CHANNEL_MAX]  = {0};
+    double   coincOff[CHANNEL_MAX] = {0};
+#endif
+    uint64_t lastPolls = 0;
 
-    // Setup interrupts
-    wiringPiISR(2,  INT_EDGE_RISING, &interrupt0); // GPIO27
-    wiringPiISR(1,  INT_EDGE_RISING, &interrupt1); // GPIO18
-    wiringPiISR(0,  INT_EDGE_RISING, &interrupt2); // GPIO17
-    wiringPiISR(6,  INT_EDGE_RISING, &interrupt3); // GPIO25
-    wiringPiISR(22, INT_EDGE_RISING, &interrupt4); // GPIO6
-    wiringPiISR(21, INT_EDGE_RISING, &interrupt5); // GPIO5
-    wiringPiISR(27, INT_EDGE_RISING, &interrupt6); // GPIO16
+    // Main loop one step below the edge path; the HAL's edge threads set
+    // their own priority (piHiPri 55 with wiringPi)
+    if (rtPriority) rtSetThread(pthread_self(), rtPriority > 1 ? rtPriority - 1 : 1, rtCpu);
 
     while (1) {
-        delay(60000); // 60 seconds
+        uint64_t tickEnd;
+        if (!ticks.wait(tickEnd)) return 1;
+        if (latencyMode) tickJitter.record(clockNs(CLOCK_REALTIME) - tickEnd);
 
-        time(&rawtime);
-        timeinfo = localtime(&rawtime);
+        // Roll the counter banks over first, so edges arriving during the
+        // work below are counted in the next tick
+        uint64_t second[CHANNEL_COUNT];
+        publisher.beginTick();
+        counters.rollover(second);
+        if (fabricMode && !fpga.deltas(fabricWord, CHANNEL_COUNT, second)) {
+            // Nothing is lost, the next read covers this tick too
+            for (size_t i = 0; i < CHANNEL_COUNT; i++) second[i] = 0;
+            fprintf(stderr, "[fpga] bank read failed\n");
+        }
+        uint64_t liveEnd  = clockNs(CLOCK_MONOTONIC);
+        uint64_t tickLive = liveEnd - liveStart;
+        liveStart = liveEnd;
+        // Closed once a boundary is crossed, not only when one is hit: a
+        // stalled loop or a stepped clock can skip the tick that lands on it
+        bool windowClosed = tickEnd >= (windowStart / windowNs + 1) * windowNs;
+        publisher.endTick(tickEnd, second, tickLive, liveStart, windowClosed);
 
-        output.open(argv[1], std::ofstream::out | std::ofstream::app);
-        output << counters[0] << ", "  // CH0 && CH1
-               << counters[1] << ", "  // CH0 && CH2
-               << counters[2] << ", "  // CH1 && CH2
-               << counters[3] << ", "  // CH0 && CH1 && CH2
-               << counters[4] << ", "  // CH0 raw
-               << counters[5] << ", "  // CH1 raw
-               << counters[6] << ", "  // CH2 raw
-               << asctime(timeinfo);
+        // FPGA counters right after the rollover, so both sides cover the
+        // same second up to the few hundred us the reads take
+        if (losses) {
+            if (fpga.deltas(lossWord, lossChannels, fpgaTick))
+                for (size_t i = 0; i < lossChannels; i++) fpgaSnapshot[i] += fpgaTick[i];
+            else
+                fpgaValid = false;
+        }
 
-        printf("%d, %d, %d, %d, %d, %d, %d, %s",
-               counters[0], counters[1], counters[2],
-               counters[3], counters[4], counters[5],
-               counters[6], asctime(timeinfo));
+        aggregates.add(tickStart, tickEnd, tickLive, second);
+        tickStart = tickEnd;
+        for (size_t i = 0; i < CHANNEL_COUNT; i++) snapshot[i] += second[i];
+        liveTime += tickLive;
+        if (!windowClosed) {
+            if (journalFile) journal.save(windowStart, tickEnd, liveTime, snapshot, windowFlags);
+            continue;
+        }
+        uint64_t windowEnd = tickEnd;
 
-        // Reset counters
-        for (int i = 0; i < 7; i++) counters[i] = 0;
-        output.close();
+        LogRecord record;
+        record.start_ns = windowStart;
+        record.end_ns   = windowEnd;
+        record.live_ns  = liveTime;
+        for (size_t i = 0; i < CHANNEL_COUNT; i++) record.counts[i] = snapshot[i];
+        record.flags    = windowFlags | (windowStart % windowNs ? LOG_FLAG_PARTIAL : 0);
+        record.reserved = 0;
+#ifdef HAVE_GPIOD
+        if (edges) {
+            uint64_t lost = 0;
+            for (size_t i = 0; i < CHANNEL_COUNT; i++) lost += edges->lost(i);
+            if (lost != kernelLost) record.flags |= LOG_FLAG_KERNEL_LOST;
+            kernelLost = lost;
+            if (eventRing.overruns() != ringOverruns) record.flags |= LOG_FLAG_RING_OVERRUN;
+            ringOverruns = eventRing.overruns();
+        }
+#endif
+        if (hitFile && (hits.lost() != hitsLost || hitRing.overruns() != hitOverruns))
+            record.flags |= LOG_FLAG_RING_OVERRUN;
+        // No good frame at all is a gap too: a bitstream without telemetry.v,
+        // or a tty that hung up, would otherwise log clean zero windows
+        if (telemetry) {
+            const TelemetryDecoder& d = telemetry->decoder();
+            if (d.missed() != uartMissed || d.crcErrors() != uartErrors || d.frames() == uartFrames ||
+                telemetry->hangups() != uartHangups || !telemetry->connected())
+                record.flags |= LOG_FLAG_UART_GAP;
+        }
+        // Per-channel loss against the FPGA, one row per channel and window
+        LossEstimate estimates[CHANNEL_COUNT];
+        bool fpgaRead = fpgaValid;
+        for (size_t i = 0; losses && fpgaRead && i < lossChannels; i++) {
+            uint64_t host = record.counts[lossHost[i]];
+            estimates[i] = estimateLoss(host, fpgaSnapshot[i], liveTime * 1e-9);
+            if (estimates[i].checked) continue;
+            fprintf(stderr, "[fpga] %s host %llu above fpga %llu, window not checked\n",
+                    CHANNEL_MAP[lossHost[i]].name, (unsigned long long)host, (unsigned long long)fpgaSnapshot[i]);
+            fpgaValid = false;
+        }
+        if (losses && fpgaValid) {
+            for (size_t i = 0; i < lossChannels; i++) {
+                uint64_t host = record.counts[lossHost[i]];
+                const LossEstimate &e = estimates[i];
+                if (e.loss > LOSS_FLAG_FRACTION) record.flags |= LOG_FLAG_HOST_LOSS;
+                fprintf(losses, "%llu,%llu,%d,%llu,%llu,%.6f,%.6f,%.1f\n",
+                        (unsigned long long)windowEnd, (unsigned long long)liveTime, lossHost[i],
+                        (unsigned long long)host, (unsigned long long)fpgaSnapshot[i],
+                        e.loss, e.correction, e.deadTime_s * 1e9);
+                fprintf(stderr, "[fpga] %s host %llu fpga %llu, lost %.3f %%, correction %.4f, dead time %.1f us\n",
+                        CHANNEL_MAP[lossHost[i]].name, (unsigned long long)host, (unsigned long long)fpgaSnapshot[i],
+                        100.0 * e.loss, e.correction, e.deadTime_s * 1e6);
+            }
+            fflush(losses);
+        } else if (losses && !fpgaRead) {
+            fprintf(stderr, "[fpga] counter reads failed, window not checked\n");
+        }
+        output.append(record);
+        if (storeFile) store.append(record);
+        // The journal lets the window go only once it is on disk: with -C or
+        // -S it could still sit in the log writer's buffer or the page cache
+        if (journalFile) {
+            if (output.commit(true)) {
+                uint64_t empty[CHANNEL_COUNT] = {0};
+                journal.save(windowEnd, windowEnd, 0, empty, 0);
+            } else {
+                fprintf(stderr, "[journal] log write failed, keeping the closed window\n");
+                journal.save(windowStart, windowEnd, liveTime, snapshot, record.flags);
+            }
+            journal.sync();
+        }
+        publisher.publishWindow(record, aggregates);
+
+        char line[320];
+        formatLogText(record, line, sizeof(line));
+        fputs(line, stdout);
+
+#ifdef HAVE_GPIOD
+        // Edges dropped by a full kernel FIFO, totals since start
+        if (edges) {
+            for (size_t i = 0; i < CHANNEL_COUNT; i++)
+                if (edges->lost(i)) fprintf(stderr, "%s lost %llu edges\n", CHANNEL_MAP[i].name, (unsigned long long)edges->lost(i));
+            fprintf(stderr, "[epoll] %llu wakeups, %llu fds serviced\n",
+                    (unsigned long long)dispatcher.wakeups(), (unsigned long long)dispatcher.serviced());
+            if (eventMode)
+                fprintf(stderr, "[events] %llu written, %llu ring overruns\n",
+                        (unsigned long long)writer.written(), (unsigned long long)eventRing.overruns());
+        }
+        // Software coincidences of this window, raw minus the mean off-time count
+        if (coincMode) {
+            std::lock_guard<std::mutex> guard(coincMutex);
+            double live = liveTime * 1e-9;
+            for (uint8_t d = 0; d < coincEngine.definitions(); d++) {
+                uint64_t on  = coincEngine.count(d) - coincOn[d];
+                double   off = coincEngine.accidentals(d) - coincOff[d];
+                coincOn[d]  = coincEngine.count(d);
+                coincOff[d] = coincEngine.accidentals(d);
+                fprintf(stderr, "[coinc] %-14s %llu on-time, accidental %.1f (%.3f Hz), net %.1f (%.3f Hz)\n",
+                        coincEngine.definition(d).name, (unsigned long long)on,
+                        off, off / live, on - off, (on - off) / live);
+            }
+            if (coincReorder.late() || coincEngine.historyLost())
+                fprintf(stderr, "[coinc] %llu late hits, %llu past the delay history\n",
+                        (unsigned long long)coincReorder.late(), (unsigned long long)coincEngine.historyLost());
+        }
+#endif
+        if (poller) {
+            uint64_t polls = poller->polls();
+            fprintf(stderr, "[poll] %.2f M GPLEV0 reads/s\n", (polls - lastPolls) / (liveTime * 1e-3));
+            lastPolls = polls;
+        }
+        if (hitFile) {
+            fprintf(stderr, "[hits] %llu stamped, %llu below the cut, %llu written, %llu lost in the FPGA, %llu ring overruns, FIFO at %u\n",
+                    (unsigned long long)hits.hits(), (unsigned long long)hits.cut(), (unsigned long long)hitWriter.written(),
+                    (unsigned long long)hits.lost(), (unsigned long long)hitRing.overruns(), hits.fill());
+            if (widths) writeWidths(widths, windowEnd, hits);
+            hitsLost    = hits.lost();
+            hitOverruns = hitRing.overruns();
+        }
+        if (telemetry) {
+            const TelemetryDecoder& d = telemetry->decoder();
+            fprintf(stderr, "[uart] %llu frames, %llu missed, %llu CRC errors, %llu bytes skipped\n",
+                    (unsigned long long)d.frames(), (unsigned long long)d.missed(),
+                    (unsigned long long)d.crcErrors(), (unsigned long long)d.skipped());
+            if (d.frames() == uartFrames && telemetry->connected() && telemetry->hangups() == uartHangups)
+                fprintf(stderr, "[uart] no frames this window, is telemetry.v in the bitstream?\n");
+            uartMissed  = d.missed();
+            uartErrors  = d.crcErrors();
+            uartFrames  = d.frames();
+            uartHangups = telemetry->hangups();
+            // Retried once a window, the flag above covers the gap
+            if (!telemetry->connected() && telemetry->reopen()) fprintf(stderr, "[uart] %s reopened\n", uartDevice);
+        }
+        stats.report(stderr, fabricMode ? "fpga" : telemetry ? "uart" : poller ? "poll" : gpioChip ? "epoll" : "isr");
+        if (latencyMode) {
+            if (gpioChip) edgeLatency.report(stderr, "edge latency");
+            tickJitter.report(stderr, "tick jitter");
+        }
+
+        windowStart = windowEnd;
+        for (size_t i = 0; i < CHANNEL_COUNT; i++) snapshot[i] = 0;
+        for (size_t i = 0; i < lossChannels; i++) fpgaSnapshot[i] = 0;
+        fpgaValid = true;
+        liveTime = 0;
+        windowFlags = 0;
     }
 
     return 0;
 }
 
-// Interrupt handlers
-void interrupt0(void) { counters[0]++; } // CH0 && CH1
-void interrupt1(void) { counters[1]++; } // CH0 && CH2
-void interrupt2(void) { counters[2]++; } // CH1 && CH2
-void interrupt3(void) { counters[3]++; } // CH0 && CH1 && CH2
-void interrupt4(void) { counters[4]++; } // CH0 raw
-void interrupt5(void) { counters[5]++; } // CH1 raw
-void interrupt6(void) { counters[6]++; } // CH2 raw
+// Edges from the register poller, same channel numbering
+void pollEdge(uint8_t channel, uint64_t timestamp_ns) {
+    Handlers::timed()[channel](timestamp_ns);
+}
+
+#ifdef HAVE_GPIOD
+// Character device edges also give the delay from the kernel's stamp
+void kernelEdge(uint8_t channel, uint64_t timestamp_ns) {
+    if (latencyMode) edgeLatency.record(clockNs(CLOCK_MONOTONIC) - timestamp_ns);
+    Handlers::timed()[channel](timestamp_ns);
+}
+#endif
+
+// FPGA hits in host time, numbered by FPGA channel
+void fpgaHit(const FpgaHit& hit, uint64_t monotonic_ns, void* ctx) {
+    (void)ctx;
+    hitRing.push(hit.channel, monotonic_ns, EVENT_FLAG_FPGA);
+}
+
+// Widths drained this window, one row per FPGA channel: counts per bucket,
+// the header giving each bucket's lower edge in ns
+void writeWidths(FILE* out, uint64_t windowEnd, FpgaHits& hits) {
+    uint64_t counts[FPGA_HIT_CHANNELS][WIDTH_BUCKETS];
+    hits.histogram().take(counts);
+    for (int c = 0; c < FPGA_HIT_CHANNELS; c++) {
+        uint64_t n = 0, seen = 0;
+        fprintf(out, "%llu,%d", (unsigned long long)windowEnd, c);
+        for (unsigned b = 0; b < WIDTH_BUCKETS; b++) {
+            fprintf(out, ",%llu", (unsigned long long)counts[c][b]);
+            n += counts[c][b];
+        }
+        fprintf(out, "\n");
+        if (n == 0) continue;
+        unsigned median = 0;
+        while (seen + counts[c][median] < (n + 1) / 2) seen += counts[c][median++];
+        fprintf(stderr, "[widths] FPGA CH%d %llu pulses, median %u-%u ns\n", c, (unsigned long long)n,
+                WidthHistogram<FPGA_HIT_CHANNELS>::bucketStart(median) * FPGA_TICK_NS,
+                median + 1 < WIDTH_BUCKETS ? WidthHistogram<FPGA_HIT_CHANNELS>::bucketStart(median + 1) * FPGA_TICK_NS
+                                           : FPGA_WIDTH_MAX * FPGA_TICK_NS);
+    }
+    fflush(out);
+}
+
+// Telemetry frame differences, from the dispatcher thread, into the rows
+// counted by each bank word
+void telemetryCounts(const uint64_t deltas[TELEMETRY_WORDS], uint16_t seq, void* ctx) {
+    (void)seq;
+    (void)ctx;
+    for (size_t i = 0; i < CHANNEL_COUNT; i++) counters.add(i, deltas[fabricWord[i]]);
+}
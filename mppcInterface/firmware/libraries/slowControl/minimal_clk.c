@@ -264,7 +264,8 @@ unsigned gpioHardwareRevision(void)
                   piPeriphBase = 0x20000000;
                   piBusAddr = 0x40000000;
                }
-               else if (strstr (buf, "ARMv7") != NULL)
+               else if ((strstr (buf, "ARMv7") != NULL) ||
+                        (strstr (buf, "ARMv8") != NULL))
                {
                   piModel = 2;
                   chars = 6;
@@ -276,6 +277,9 @@ unsigned gpioHardwareRevision(void)
 
          if (!strncasecmp("revision", buf, 8))
          {
+            /* 64 bit kernels print no model name, take the whole code */
+            if (piModel == 0) chars = strlen(strchr(buf, ':') + 2) - 1;
+
             if (sscanf(buf+strlen(buf)-(chars+1),
                "%x%c", &rev, &term) == 2)
             {
@@ -286,6 +290,14 @@ unsigned gpioHardwareRevision(void)
 
       fclose(filp);
    }
+
+   /* New style revision codes, bits 12-15 = 3: BCM2711 (Pi 4, CM4, Pi 400) */
+   if ((rev & 0x800000) && (((rev >> 12) & 0xF) == 3))
+   {
+      piModel = 3;
+      piPeriphBase = 0xFE000000;
+      piBusAddr = 0xC0000000;
+   }
    return rev;
 }
 
@@ -0,0 +1,65 @@
+// Process CPU time, context switches and thread count, reported per window
+// so the wiringPiISR and epoll input models can be compared on the same Pi.
+#ifndef __PROCSTATS_H__
+#define __PROCSTATS_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+
+class ProcStats {
+ public:
+  ProcStats() { sample(_last); }
+
+  // One line with rates since the previous call, getrusage sums all threads
+  void report(FILE *out, const char label[]) {
+    Sample now;
+    sample(now);
+    double wall = now.wall - _last.wall;
+    double cpu  = now.cpu  - _last.cpu;
+    if (wall <= 0) wall = 1;
+    fprintf(out, "[%s] cpu %.3f s (%.2f%%), %.1f vol + %.1f invol ctxsw/s, %d threads\n",
+            label, cpu, 100.0 * cpu / wall,
+            (now.nvcsw - _last.nvcsw) / wall, (now.nivcsw - _last.nivcsw) / wall,
+            threads());
+    _last = now;
+  }
+
+ private:
+
+  struct Sample {
+    double wall;
+    double cpu;
+    long nvcsw;
+    long nivcsw;
+  };
+
+  static void sample(Sample &s) {
+    struct timespec ts;
+    struct rusage ru;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    getrusage(RUSAGE_SELF, &ru);
+    s.wall   = ts.tv_sec + ts.tv_nsec * 1e-9;
+    s.cpu    = ru.ru_utime.tv_sec + ru.ru_utime.tv_usec * 1e-6 +
+               ru.ru_stime.tv_sec + ru.ru_stime.tv_usec * 1e-6;
+    s.nvcsw  = ru.ru_nvcsw;
+    s.nivcsw = ru.ru_nivcsw;
+  }
+
+  static int threads() {
+    FILE *f = fopen("/proc/self/status", "r");
+    if (!f) return -1;
+    char line[128];
+    int n = -1;
+    while (fgets(line, sizeof(line), f))
+      if (strncmp(line, "Threads:", 8) == 0) { n = atoi(line + 8); break; }
+    fclose(f);
+    return n;
+  }
+
+  Sample _last;
+};
+
+#endif //__PROCSTATS_H__
@@ -0,0 +1,60 @@
+// Multi-resolution rolling count aggregates for slowControl.
+// The main loop feeds one 1 s bin per tick; every coarser level is summed
+// from closed bins of the level below, never rescanned. Each level keeps a
+// fixed number of recent bins in a circular buffer and can stream closed
+// bins to its own CSV file.
+#ifndef __RATEAGGREGATES_H__
+#define __RATEAGGREGATES_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "channelMap.h"
+
+#define AGG_LEVELS   4
+#define AGG_CHANNELS CHANNEL_COUNT
+
+struct AggBin {
+  uint64_t start_ns;   // CLOCK_REALTIME, first tick in the bin
+  uint64_t end_ns;     // CLOCK_REALTIME, aligned to the level period
+  uint64_t live_ns;    // counting time actually covered
+  uint64_t counts[AGG_CHANNELS];
+};
+
+class RateAggregates {
+ public:
+  RateAggregates();
+  ~RateAggregates();
+
+  // Stream closed bins of every level to <prefix>_<period>s.csv
+  bool openStreams(const char prefix[]);
+
+  // One closed 1 s tick, end_ns on a whole second
+  void add(uint64_t start_ns, uint64_t end_ns, uint64_t live_ns, const uint64_t counts[AGG_CHANNELS]);
+
+  // Up to max most recent closed bins of a level, newest first
+  size_t latest(int level, AggBin *out, size_t max) const;
+
+  uint32_t period(int level) const { return _levels[level].period; }
+
+ private:
+
+  struct Level {
+    uint32_t period;     // seconds
+    size_t   capacity;   // bins kept
+    AggBin  *bins;
+    size_t   head;       // next slot to write
+    size_t   filled;
+    AggBin   partial;    // bin being summed
+    bool     open;
+    FILE    *stream;
+  };
+
+  void accumulate(int level, const AggBin &bin);
+  void close(int level);
+
+  Level _levels[AGG_LEVELS];
+};
+
+#endif //__RATEAGGREGATES_H__
@@ -0,0 +1,54 @@
+// realtime.cpp — memory locking and SCHED_FIFO for slowControl threads
+// - Needs CAP_SYS_NICE and CAP_IPC_LOCK (or root), reports and carries on
+//   without them
+// - The main stack is pre-faulted by writing a volatile block below us
+// Build: g++ -O2 -std=c++11 -c realtime.cpp (link -lpthread)
+
+#include <cstdio>
+#include <cstring>
+
+#include <malloc.h>
+#include <sched.h>
+#include <sys/mman.h>
+
+#include "realtime.h"
+
+static void prefaultStack() {
+  volatile unsigned char block[RT_STACK_PREFAULT];
+  for (size_t i = 0; i < sizeof(block); i += 4096) block[i] = 0;
+}
+
+bool rtLockMemory() {
+  if (mlockall(MCL_CURRENT | MCL_FUTURE) < 0) {
+    std::perror("mlockall");
+    return false;
+  }
+  // Freed heap stays mapped and locked, no malloc goes to a fresh mmap
+  mallopt(M_TRIM_THRESHOLD, -1);
+  mallopt(M_MMAP_MAX, 0);
+  prefaultStack();
+  return true;
+}
+
+bool rtSetThread(pthread_t thread, int priority, int cpu) {
+  bool ok = true;
+  if (cpu >= 0) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    int err = pthread_setaffinity_np(thread, sizeof(set), &set);
+    if (err) {
+      std::fprintf(stderr, "pthread_setaffinity_np CPU %d: %s\n", cpu, strerror(err));
+      ok = false;
+    }
+  }
+  struct sched_param param;
+  std::memset(&param, 0, sizeof(param));
+  param.sched_priority = priority;
+  int err = pthread_setschedparam(thread, SCHED_FIFO, &param);
+  if (err) {
+    std::fprintf(stderr, "SCHED_FIFO priority %d: %s\n", priority, strerror(err));
+    ok = false;
+  }
+  return ok;
+}
@@ -0,0 +1,21 @@
+// Opt-in real-time profile for the slowControl counting path (-R).
+//
+// Memory is locked before any thread starts, so later thread stacks and
+// buffers are faulted in and pinned when they are mapped; the main stack
+// grows on demand and is pre-faulted by hand. Counting threads then move to
+// SCHED_FIFO on a chosen core, ahead of cron, scp and the bias daemon.
+#ifndef __REALTIME_H__
+#define __REALTIME_H__
+
+#include <pthread.h>
+
+#define RT_STACK_PREFAULT (512 * 1024)
+
+// mlockall(current | future), no heap trimming or mmap'd mallocs, and the
+// calling thread's stack touched down to RT_STACK_PREFAULT
+bool rtLockMemory();
+
+// SCHED_FIFO at priority (1-99) and, for cpu >= 0, pinned to that core
+bool rtSetThread(pthread_t thread, int priority, int cpu);
+
+#endif //__REALTIME_H__
@@ -8,4 +8,4 @@ timestamp=$(date +"%Y-%m-%d_%H-%M-%S")
 filename="TempTest_EA_0x2F1_${timestamp}.log"
 
 # Run main script with generated filename
-./main "$filename"
+./main -J slowControl.journal "$filename"
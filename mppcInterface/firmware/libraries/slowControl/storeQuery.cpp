@@ -0,0 +1,50 @@
+// storeQuery.cpp — sum a time range of a slowControl count store
+// Prints windows, live time, counts and rates per channel for
+// [from, to) and how long the scan took.
+// Build: make storeQuery
+// Usage: ./storeQuery <store_file> <from_epoch_s> <to_epoch_s>
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <chrono>
+
+#include "countStore.h"
+
+int main(int argc, char** argv) {
+  if (argc < 4) {
+    fprintf(stderr, "Usage: %s <store_file> <from_epoch_s> <to_epoch_s>\n", argv[0]);
+    return 1;
+  }
+
+  CountStoreReader store;
+  if (!store.open(argv[1])) return 1;
+  uint64_t from = strtoull(argv[2], NULL, 10) * 1000000000ULL;
+  uint64_t to   = strtoull(argv[3], NULL, 10) * 1000000000ULL;
+
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+
+  std::vector<StoreSlice> slices(STORE_MAX_CHUNKS);
+  size_t n = store.range(from, to, slices.data(), slices.size());
+
+  uint64_t windows = 0, live = 0;
+  uint64_t counts[LOG_CHANNELS] = {0};
+  for (size_t s = 0; s < n; s++) {
+    const StoreSlice &slice = slices[s];
+    windows += slice.rows;
+    for (size_t r = 0; r < slice.rows; r++) live += slice.columns[COL_LIVE][r];
+    for (size_t ch = 0; ch < LOG_CHANNELS; ch++) {
+      const uint64_t *col = slice.columns[COL_COUNT0 + ch];
+      for (size_t r = 0; r < slice.rows; r++) counts[ch] += col[r];
+    }
+  }
+
+  double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+  printf("%llu windows in %zu chunks, live %.1f s, scanned in %.3f ms\n",
+         (unsigned long long)windows, n, live * 1e-9, ms);
+  for (size_t ch = 0; ch < LOG_CHANNELS; ch++)
+    printf("counter %zu %-14s %llu (%.4f Hz)\n", ch, CHANNEL_MAP[ch].name, (unsigned long long)counts[ch],
+           live ? counts[ch] / (live * 1e-9) : 0.0);
+  return 0;
+}
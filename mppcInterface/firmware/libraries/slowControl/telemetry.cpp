@@ -0,0 +1,212 @@
+// telemetry.cpp — decoder and termios/epoll reader of the FPGA telemetry frames
+// - Sync hunt a byte at a time, so a corrupt frame costs only itself
+// - Raw 115200 8N1, non-blocking, VMIN=VTIME=0; the dispatcher's epoll set
+//   says when to read and onReady drains the tty until it reads empty
+// - A hangup closes the tty and counts it; reopen() from the main loop
+//   brings it back, the gap shows as windows without frames
+// - Counts are differenced in 32 bits, a sequence restart (FPGA reconfigured)
+//   primes again instead of producing a bogus difference
+// Build: g++ -O2 -std=c++11 -c telemetry.cpp
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "telemetry.h"
+
+uint16_t telemetryCrc(const uint8_t *data, size_t length) {
+  uint16_t crc = 0xFFFF;
+  for (size_t i = 0; i < length; i++) {
+    crc ^= (uint16_t)data[i] << 8;
+    for (int b = 0; b < 8; b++)
+      crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+  }
+  return crc;
+}
+
+void encodeTelemetry(const TelemetryFrame &frame, uint8_t out[TELEMETRY_FRAME_BYTES]) {
+  out[0] = TELEMETRY_SYNC0;
+  out[1] = TELEMETRY_SYNC1;
+  out[2] = frame.seq >> 8;
+  out[3] = frame.seq & 0xFF;
+  out[4] = TELEMETRY_WORDS;
+  for (int w = 0; w < TELEMETRY_WORDS; w++) {
+    out[5 + 4*w] = frame.counts[w] >> 24;
+    out[6 + 4*w] = frame.counts[w] >> 16;
+    out[7 + 4*w] = frame.counts[w] >> 8;
+    out[8 + 4*w] = frame.counts[w];
+  }
+  uint16_t crc = telemetryCrc(out + 2, TELEMETRY_FRAME_BYTES - 4);
+  out[TELEMETRY_FRAME_BYTES - 2] = crc >> 8;
+  out[TELEMETRY_FRAME_BYTES - 1] = crc & 0xFF;
+}
+
+TelemetryDecoder::TelemetryDecoder(FrameHandler handler, void *ctx) {
+  _handler   = handler;
+  _ctx       = ctx;
+  _have      = 0;
+  _seqValid  = false;
+  _lastSeq   = 0;
+  _frames    = 0;
+  _crcErrors = 0;
+  _missed    = 0;
+  _skipped   = 0;
+}
+
+void TelemetryDecoder::drop(size_t n) {
+  std::memmove(_buffer, _buffer + n, _have - n);
+  _have -= n;
+  _skipped += n;
+}
+
+void TelemetryDecoder::feed(const uint8_t *data, size_t length) {
+  for (size_t i = 0; i < length; i++) {
+    _buffer[_have++] = data[i];
+
+    while (_have) {
+      if (_buffer[0] != TELEMETRY_SYNC0 || (_have > 1 && _buffer[1] != TELEMETRY_SYNC1)) {
+        drop(1);
+        continue;
+      }
+      if (_have < TELEMETRY_FRAME_BYTES) break;
+
+      uint16_t crc = (uint16_t)(_buffer[TELEMETRY_FRAME_BYTES - 2] << 8) | _buffer[TELEMETRY_FRAME_BYTES - 1];
+      if (_buffer[4] != TELEMETRY_WORDS || telemetryCrc(_buffer + 2, TELEMETRY_FRAME_BYTES - 4) != crc) {
+        // Not a frame after all, or a damaged one: look for the next sync
+        // inside it
+        _crcErrors++;
+        drop(1);
+        continue;
+      }
+
+      TelemetryFrame frame;
+      frame.seq = (uint16_t)(_buffer[2] << 8) | _buffer[3];
+      for (int w = 0; w < TELEMETRY_WORDS; w++) {
+        const uint8_t *b = _buffer + 5 + 4*w;
+        frame.counts[w] = (uint32_t)b[0] << 24 | (uint32_t)b[1] << 16 | (uint32_t)b[2] << 8 | b[3];
+      }
+      if (_seqValid && !(frame.seq == 0 && _lastSeq != 0xFFFF))
+        _missed += (uint16_t)(frame.seq - _lastSeq - 1);
+      _seqValid = true;
+      _lastSeq  = frame.seq;
+      _have     = 0;
+      _frames++;
+      _handler(frame, _ctx);
+    }
+  }
+}
+
+TelemetryReader::TelemetryReader(const char device[], CountsHandler handler, void *ctx)
+  : _decoder(onFrame, this) {
+  _device     = device;
+  _dispatcher = NULL;
+  _fd         = -1;
+  _hangups    = 0;
+  _handler    = handler;
+  _ctx        = ctx;
+  _primed     = false;
+  _lastSeq    = 0;
+  std::memset(_last, 0, sizeof(_last));
+}
+
+TelemetryReader::~TelemetryReader() {
+  if (_fd >= 0) close(_fd);
+}
+
+bool TelemetryReader::attach(EdgeDispatcher &dispatcher) {
+  _dispatcher = &dispatcher;
+  return openDevice();
+}
+
+bool TelemetryReader::reopen() {
+  if (_fd >= 0) return true;
+  if (!_dispatcher) return false;
+  return openDevice();
+}
+
+bool TelemetryReader::openDevice() {
+  int fd = open(_device, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+  if (fd < 0) {
+    std::perror(_device);
+    return false;
+  }
+
+  struct termios tio;
+  if (tcgetattr(fd, &tio) < 0) {
+    std::perror("tcgetattr");
+    close(fd);
+    return false;
+  }
+  cfmakeraw(&tio);
+  cfsetispeed(&tio, B115200);
+  cfsetospeed(&tio, B115200);
+  tio.c_cflag |= CLOCAL | CREAD;
+  tio.c_cc[VMIN]  = 0;
+  tio.c_cc[VTIME] = 0;
+  if (tcsetattr(fd, TCSANOW, &tio) < 0) {
+    std::perror("tcsetattr");
+    close(fd);
+    return false;
+  }
+  tcflush(fd, TCIFLUSH);
+
+  // Set before the dispatcher can call onReady for it
+  _fd = fd;
+  if (!_dispatcher->add(fd, onReady, this, 0)) {
+    close(fd);
+    _fd = -1;
+    return false;
+  }
+  return true;
+}
+
+void TelemetryReader::onReady(void *ctx, uint32_t tag) {
+  (void)tag;
+  TelemetryReader *self = (TelemetryReader *)ctx;
+  uint8_t buffer[256];
+  bool any = false;
+
+  while (1) {
+    ssize_t n = read(self->_fd, buffer, sizeof(buffer));
+    if (n > 0) {
+      self->_decoder.feed(buffer, n);
+      any = true;
+      continue;
+    }
+    // VMIN=VTIME=0 reads 0 once the tty is empty, but 0 straight after
+    // epoll said ready is a hangup
+    if (n == 0 && any) break;
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+    if (n < 0 && errno == EINTR) continue;
+
+    // Hung up or gone: closing drops it from the epoll set, which would
+    // otherwise report it ready forever
+    if (n < 0) std::perror(self->_device);
+    else std::fprintf(stderr, "%s: hung up\n", self->_device);
+    close(self->_fd);
+    self->_fd = -1;
+    self->_hangups++;
+    break;
+  }
+}
+
+void TelemetryReader::onFrame(const TelemetryFrame &frame, void *ctx) {
+  TelemetryReader *self = (TelemetryReader *)ctx;
+
+  // seq 0 after anything but 0xFFFF: the FPGA started counting again
+  bool restart = frame.seq == 0 && self->_lastSeq != 0xFFFF;
+  if (self->_primed && !restart) {
+    uint64_t deltas[TELEMETRY_WORDS];
+    for (int w = 0; w < TELEMETRY_WORDS; w++)
+      deltas[w] = (uint32_t)(frame.counts[w] - self->_last[w]);
+    self->_handler(deltas, frame.seq, self->_ctx);
+  }
+  for (int w = 0; w < TELEMETRY_WORDS; w++)
+    self->_last[w] = frame.counts[w];
+  self->_lastSeq = frame.seq;
+  self->_primed  = true;
+}
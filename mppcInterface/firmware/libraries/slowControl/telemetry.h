@@ -0,0 +1,102 @@
+// Reader of the FPGA's once-a-second telemetry frames (gateware telemetry.v).
+//
+// TelemetryDecoder hunts for the sync bytes in a byte stream, checks every
+// frame's CRC and sequence number and hands good frames on. TelemetryReader
+// puts a serial device in raw non-blocking mode, services it from an
+// EdgeDispatcher (epoll, no thread of its own) and turns the running counts
+// of consecutive good frames into per-word differences. Counts are
+// cumulative, so missed or corrupt frames are flagged but lose nothing. A
+// device that hangs up is closed and can be opened again with reopen().
+#ifndef __TELEMETRY_H__
+#define __TELEMETRY_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "edgeDispatcher.h"
+
+#define TELEMETRY_WORDS 8          // counter bank words, fpgaBankWord() order
+#define TELEMETRY_FRAME_BYTES 39
+#define TELEMETRY_SYNC0 0xA5
+#define TELEMETRY_SYNC1 0x5A
+
+struct TelemetryFrame {
+  uint16_t seq;
+  uint32_t counts[TELEMETRY_WORDS];
+};
+
+// CRC-16/CCITT-FALSE, as telemetry.v computes it over bytes 2-36
+uint16_t telemetryCrc(const uint8_t *data, size_t length);
+
+// The frame as the FPGA sends it, for stand-ins
+void encodeTelemetry(const TelemetryFrame &frame, uint8_t out[TELEMETRY_FRAME_BYTES]);
+
+class TelemetryDecoder {
+ public:
+  typedef void (*FrameHandler)(const TelemetryFrame &frame, void *ctx);
+
+  TelemetryDecoder(FrameHandler handler, void *ctx);
+
+  void feed(const uint8_t *data, size_t length);
+
+  uint64_t frames() const { return _frames; }         // good ones
+  uint64_t crcErrors() const { return _crcErrors; }
+  uint64_t missed() const { return _missed; }         // by sequence number
+  uint64_t skipped() const { return _skipped; }       // bytes outside frames
+
+ private:
+
+  void drop(size_t n);
+
+  FrameHandler _handler;
+  void *_ctx;
+  uint8_t _buffer[TELEMETRY_FRAME_BYTES];
+  size_t _have;
+  bool _seqValid;
+  uint16_t _lastSeq;
+
+  volatile uint64_t _frames;
+  volatile uint64_t _crcErrors;
+  volatile uint64_t _missed;
+  volatile uint64_t _skipped;
+};
+
+class TelemetryReader {
+ public:
+  // Counts since the previous good frame, per bank word, from the
+  // dispatcher thread. The first frame only primes.
+  typedef void (*CountsHandler)(const uint64_t deltas[TELEMETRY_WORDS], uint16_t seq, void *ctx);
+
+  TelemetryReader(const char device[], CountsHandler handler, void *ctx);
+  ~TelemetryReader();
+
+  // Open the device raw at 115200 8N1 and register it with the dispatcher
+  bool attach(EdgeDispatcher &dispatcher);
+
+  // After a hangup: open the device again with the same dispatcher
+  bool connected() const { return _fd >= 0; }
+  bool reopen();
+  uint64_t hangups() const { return _hangups; }
+
+  const TelemetryDecoder &decoder() const { return _decoder; }
+
+ private:
+
+  bool openDevice();
+
+  static void onReady(void *ctx, uint32_t tag);
+  static void onFrame(const TelemetryFrame &frame, void *ctx);
+
+  const char *_device;
+  EdgeDispatcher *_dispatcher;
+  volatile int _fd;              // -1 once hung up, set by the dispatcher thread
+  volatile uint64_t _hangups;
+  TelemetryDecoder _decoder;
+  CountsHandler _handler;
+  void *_ctx;
+  bool _primed;
+  uint16_t _lastSeq;
+  uint32_t _last[TELEMETRY_WORDS];
+};
+
+#endif //__TELEMETRY_H__
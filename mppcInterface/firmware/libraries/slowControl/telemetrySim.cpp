@@ -0,0 +1,116 @@
+// telemetrySim.cpp — stand-in for the FPGA's UART telemetry on a pseudo-terminal
+// - Prints the slave side's path, point ./main -U at it
+// - A frame every period, running counts advanced by Poisson draws: rate on
+//   words 0-3, rate / 1000 on the coincidence words 4-7
+// - Every Nth frame corrupted (-c) or left out (-d), to exercise the CRC
+//   check, the sync hunt and the missed-frame accounting
+// - Totals sent, per word, printed on exit (Ctrl-C or -n frames)
+// Build: make telemetrySim
+// Usage: ./telemetrySim [-r rate_hz] [-i period_ms] [-n frames] [-c every] [-d every]
+
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "telemetry.h"
+
+static volatile sig_atomic_t running = 1;
+
+static void onSignal(int) { running = 0; }
+
+static void usage(const char name[]) {
+  fprintf(stderr, "Usage: %s [-r rate_hz] [-i period_ms] [-n frames] [-c corrupt_every] [-d drop_every]\n", name);
+}
+
+int main(int argc, char** argv) {
+  double rate      = 1000;
+  int periodMs     = 1000;
+  long frames      = 0;   // 0 = until interrupted
+  int corruptEvery = 0;
+  int dropEvery    = 0;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "r:i:n:c:d:h")) != -1) {
+    switch (opt) {
+      case 'r': rate         = atof(optarg); break;
+      case 'i': periodMs     = atoi(optarg); break;
+      case 'n': frames       = atol(optarg); break;
+      case 'c': corruptEvery = atoi(optarg); break;
+      case 'd': dropEvery    = atoi(optarg); break;
+      default:  usage(argv[0]); return 1;
+    }
+  }
+  if (rate < 0 || periodMs <= 0 || frames < 0 || corruptEvery < 0 || dropEvery < 0) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  int master = posix_openpt(O_RDWR | O_NOCTTY);
+  if (master < 0 || grantpt(master) < 0 || unlockpt(master) < 0) {
+    perror("pty");
+    return 1;
+  }
+  // Nobody reading yet is no reason to stall
+  fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+  printf("%s\n", ptsname(master));
+  fflush(stdout);
+
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+
+  std::mt19937_64 rng(time(NULL));
+  double period = periodMs * 1e-3;
+  std::poisson_distribution<uint64_t> raw(rate * period);
+  std::poisson_distribution<uint64_t> coincidence(rate * period * 1e-3);
+
+  TelemetryFrame frame;
+  frame.seq = 0;
+  uint64_t totals[TELEMETRY_WORDS] = {0};
+  for (int w = 0; w < TELEMETRY_WORDS; w++) frame.counts[w] = 0;
+
+  struct timespec next;
+  clock_gettime(CLOCK_MONOTONIC, &next);
+  long sent = 0, corrupted = 0, dropped = 0;
+  for (long n = 1; running && (frames == 0 || n <= frames); n++) {
+    next.tv_nsec += periodMs % 1000 * 1000000L;
+    next.tv_sec  += periodMs / 1000 + next.tv_nsec / 1000000000L;
+    next.tv_nsec %= 1000000000L;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) == EINTR && running) {}
+    if (!running) break;
+
+    for (int w = 0; w < TELEMETRY_WORDS; w++) {
+      uint64_t k = w < 4 ? raw(rng) : coincidence(rng);
+      frame.counts[w] += k;
+      totals[w] += k;
+    }
+
+    uint8_t bytes[TELEMETRY_FRAME_BYTES];
+    encodeTelemetry(frame, bytes);
+    frame.seq++;
+    if (dropEvery && n % dropEvery == 0) {
+      dropped++;
+      continue;
+    }
+    if (corruptEvery && n % corruptEvery == 0) {
+      bytes[5 + rng() % (TELEMETRY_FRAME_BYTES - 7)] ^= 1 << (rng() % 8);
+      corrupted++;
+    }
+    if (write(master, bytes, sizeof(bytes)) != (ssize_t)sizeof(bytes) && errno != EAGAIN) {
+      perror("write");
+      break;
+    }
+    sent++;
+  }
+
+  fprintf(stderr, "%ld frames sent, %ld corrupted, %ld dropped\n", sent, corrupted, dropped);
+  for (int w = 0; w < TELEMETRY_WORDS; w++)
+    fprintf(stderr, "word %d: %llu\n", w, (unsigned long long)totals[w]);
+  close(master);
+  return 0;
+}
@@ -0,0 +1,63 @@
+// Per-channel histogram of FPGA pulse widths (time over threshold).
+//
+// Buckets are exact below 8 ticks, then 4 per power of two (at most 25 %
+// wide) up to the FPGA's 16-bit saturation, so the whole histogram is a
+// fixed array of N x 60 counters. record() is a relaxed atomic increment,
+// from the drain thread; take() hands the reader every count since its
+// previous call and, like LatencyHistogram, never stops the writer.
+#ifndef __WIDTHHISTOGRAM_H__
+#define __WIDTHHISTOGRAM_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+#define WIDTH_SUB_BITS 2
+#define WIDTH_BUCKETS  ((17 - WIDTH_SUB_BITS) << WIDTH_SUB_BITS)   // up to 2^16 ticks
+
+template <size_t N>
+class WidthHistogram {
+ public:
+  WidthHistogram() {
+    for (size_t c = 0; c < N; c++)
+      for (int b = 0; b < WIDTH_BUCKETS; b++) {
+        _counts[c][b].store(0, std::memory_order_relaxed);
+        _taken[c][b] = 0;
+      }
+  }
+
+  inline void record(size_t channel, uint32_t ticks) {
+    unsigned b = bucket(ticks);
+    _counts[channel][b < WIDTH_BUCKETS ? b : WIDTH_BUCKETS - 1].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Counts since the previous call, reader side only
+  void take(uint64_t out[N][WIDTH_BUCKETS]) {
+    for (size_t c = 0; c < N; c++)
+      for (int b = 0; b < WIDTH_BUCKETS; b++) {
+        uint64_t v = _counts[c][b].load(std::memory_order_relaxed);
+        out[c][b] = v - _taken[c][b];
+        _taken[c][b] = v;
+      }
+  }
+
+  static inline unsigned bucket(uint32_t ticks) {
+    if (ticks < (2u << WIDTH_SUB_BITS)) return ticks;
+    unsigned shift = 31 - __builtin_clz(ticks) - WIDTH_SUB_BITS;
+    return (shift << WIDTH_SUB_BITS) + (ticks >> shift);
+  }
+
+  // Smallest width of bucket b
+  static inline uint32_t bucketStart(unsigned b) {
+    if (b < (2u << WIDTH_SUB_BITS)) return b;
+    unsigned shift = (b >> WIDTH_SUB_BITS) - 1;
+    return ((b & ((1u << WIDTH_SUB_BITS) - 1)) | 1u << WIDTH_SUB_BITS) << shift;
+  }
+
+ private:
+
+  std::atomic<uint64_t> _counts[N][WIDTH_BUCKETS];
+  uint64_t _taken[N][WIDTH_BUCKETS];   // reader side only
+};
+
+#endif //__WIDTHHISTOGRAM_H__
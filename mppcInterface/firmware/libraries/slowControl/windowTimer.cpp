@@ -0,0 +1,66 @@
+// windowTimer.cpp — wall-clock-aligned window boundaries from a timerfd
+// - TFD_TIMER_ABSTIME on CLOCK_REALTIME, first expiry on the next boundary
+// - Interval re-arms from the expiry time, not from when we got to read()
+// - TFD_TIMER_CANCEL_ON_SET reports NTP/RTC steps so we can realign
+// Build: g++ -O2 -std=c++11 -c windowTimer.cpp
+
+#include <cerrno>
+#include <cstdio>
+
+#include <unistd.h>
+#include <sys/timerfd.h>
+
+#include "windowTimer.h"
+
+WindowTimer::WindowTimer(uint32_t periodSec) {
+  _period_ns = (uint64_t)periodSec * 1000000000ULL;
+  _next_ns   = 0;
+  _fd = timerfd_create(CLOCK_REALTIME, TFD_CLOEXEC);
+  if (_fd < 0) std::perror("timerfd_create");
+}
+
+WindowTimer::~WindowTimer() {
+  if (_fd >= 0) close(_fd);
+}
+
+bool WindowTimer::start() {
+  if (_fd < 0 || _period_ns == 0) return false;
+  return arm();
+}
+
+bool WindowTimer::arm() {
+  uint64_t now = clockNs(CLOCK_REALTIME);
+  _next_ns = (now / _period_ns + 1) * _period_ns;
+
+  struct itimerspec spec;
+  spec.it_value.tv_sec     = _next_ns / 1000000000ULL;
+  spec.it_value.tv_nsec    = _next_ns % 1000000000ULL;
+  spec.it_interval.tv_sec  = _period_ns / 1000000000ULL;
+  spec.it_interval.tv_nsec = _period_ns % 1000000000ULL;
+  if (timerfd_settime(_fd, TFD_TIMER_ABSTIME | TFD_TIMER_CANCEL_ON_SET, &spec, NULL) < 0) {
+    std::perror("timerfd_settime");
+    return false;
+  }
+  return true;
+}
+
+bool WindowTimer::wait(uint64_t &boundary_ns) {
+  while (1) {
+    uint64_t expirations;
+    ssize_t n = read(_fd, &expirations, sizeof(expirations));
+    if (n == sizeof(expirations)) {
+      // More than one expiry means we were not scheduled for a whole window
+      boundary_ns = _next_ns + (expirations - 1) * _period_ns;
+      _next_ns = boundary_ns + _period_ns;
+      return true;
+    }
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0 && errno == ECANCELED) {
+      std::fprintf(stderr, "Wall clock stepped, realigning windows\n");
+      if (!arm()) return false;
+      continue;
+    }
+    std::perror("timerfd read");
+    return false;
+  }
+}
@@ -0,0 +1,41 @@
+// Absolute-deadline integration windows for slowControl.
+// A CLOCK_REALTIME timerfd fires on exact multiples of the window length
+// (like biasAdj.py's align_to_next_boundary), so boundaries never drift and
+// all stations close their windows on the same instants.
+#ifndef __WINDOWTIMER_H__
+#define __WINDOWTIMER_H__
+
+#include <stdint.h>
+#include <time.h>
+
+inline uint64_t clockNs(clockid_t clock) {
+  struct timespec ts;
+  clock_gettime(clock, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+class WindowTimer {
+ public:
+  WindowTimer(uint32_t periodSec);
+  ~WindowTimer();
+
+  // Arm for the next boundary after now
+  bool start();
+
+  // Block until the next boundary, boundary_ns is its CLOCK_REALTIME time.
+  // A step of the wall clock realigns to the new time instead of firing early.
+  bool wait(uint64_t &boundary_ns);
+
+  int fd() const { return _fd; }
+  uint64_t period_ns() const { return _period_ns; }
+
+ private:
+
+  bool arm();
+
+  int _fd;
+  uint64_t _period_ns;
+  uint64_t _next_ns;
+};
+
+#endif //__WINDOWTIMER_H__
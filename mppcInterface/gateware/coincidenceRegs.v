@@ -0,0 +1,143 @@
+// Coincidence outputs programmed from the Pi, replacing the hard-wired ANDs.
+//
+// Registers, 32 bits each, read and written through counterSpi.v:
+//   0    id, C5 01 04 04 (register file version 1, 4 outputs, 4 channels)
+//   1    window length in CLK cycles, bits WINDOW_BITS-1..0
+//   2-5  output 0-3: channel mask in bits 3-0, threshold in bits 10-8
+// Output n is high while at least threshold of its masked channels are
+// within the window of their last rising edge. A window of 0 uses the
+// channel levels instead, so threshold = number of masked channels is the
+// plain AND of the old bitstreams. Threshold 0 switches the output off.
+//
+// stage copies the live registers, writes change the copy, and commit makes
+// all of it live in one cycle, so the outputs never see half a layout.
+// Counters downstream keep counting throughout.
+module coincidenceRegs (
+    input CLK,
+    input rst,
+    input [3:0] raw,
+    input stage,
+    input wr,
+    input [2:0] wrAddr,
+    input [31:0] wrData,
+    input commit,
+    input [2:0] addr,
+    output reg [31:0] readData,
+    output reg [3:0] out,
+);
+
+// 8 on the LP384, where four 16-bit window timers do not fit
+parameter WINDOW_BITS = 16;
+
+localparam ID = 32'hC5010404;
+
+function [2:0] hitCount;
+    input [3:0] hits;
+    begin
+        hitCount = hits[0] + hits[1] + hits[2] + hits[3];
+    end
+endfunction
+
+// Live and staged registers
+reg [WINDOW_BITS - 1:0] window;
+reg [3:0] mask0;
+reg [3:0] mask1;
+reg [3:0] mask2;
+reg [3:0] mask3;
+reg [2:0] threshold0;
+reg [2:0] threshold1;
+reg [2:0] threshold2;
+reg [2:0] threshold3;
+reg [WINDOW_BITS - 1:0] windowNext;
+reg [10:0] outNext0;
+reg [10:0] outNext1;
+reg [10:0] outNext2;
+reg [10:0] outNext3;
+
+always @(posedge CLK) begin
+    if (rst) begin
+        // The layout of the fixed bitstreams: CH0&&CH1, CH0&&CH2, CH1&&CH2,
+        // CH0&&CH1&&CH2
+        window     <= 0;
+        mask0      <= 4'b0011;
+        mask1      <= 4'b0101;
+        mask2      <= 4'b0110;
+        mask3      <= 4'b0111;
+        threshold0 <= 2;
+        threshold1 <= 2;
+        threshold2 <= 2;
+        threshold3 <= 3;
+    end else if (commit) begin
+        window     <= windowNext;
+        mask0      <= outNext0[3:0];
+        mask1      <= outNext1[3:0];
+        mask2      <= outNext2[3:0];
+        mask3      <= outNext3[3:0];
+        threshold0 <= outNext0[10:8];
+        threshold1 <= outNext1[10:8];
+        threshold2 <= outNext2[10:8];
+        threshold3 <= outNext3[10:8];
+    end
+
+    if (stage) begin
+        windowNext <= window;
+        outNext0   <= {threshold0, 4'b0, mask0};
+        outNext1   <= {threshold1, 4'b0, mask1};
+        outNext2   <= {threshold2, 4'b0, mask2};
+        outNext3   <= {threshold3, 4'b0, mask3};
+    end else if (wr) begin
+        case (wrAddr)
+            3'd1: windowNext <= wrData[WINDOW_BITS - 1:0];
+            3'd2: outNext0   <= {wrData[10:8], 4'b0, wrData[3:0]};
+            3'd3: outNext1   <= {wrData[10:8], 4'b0, wrData[3:0]};
+            3'd4: outNext2   <= {wrData[10:8], 4'b0, wrData[3:0]};
+            3'd5: outNext3   <= {wrData[10:8], 4'b0, wrData[3:0]};
+            default: ;
+        endcase
+    end
+end
+
+always @(*) begin
+    case (addr)
+        3'd0: readData = ID;
+        3'd1: readData = window;
+        3'd2: readData = {21'b0, threshold0, 4'b0, mask0};
+        3'd3: readData = {21'b0, threshold1, 4'b0, mask1};
+        3'd4: readData = {21'b0, threshold2, 4'b0, mask2};
+        3'd5: readData = {21'b0, threshold3, 4'b0, mask3};
+        default: readData = 0;
+    endcase
+end
+
+// Channels synchronised to CLK, then held for the window after each rise
+reg [3:0] rawSync0;
+reg [3:0] rawSync1;
+reg [3:0] rawSync2;
+always @(posedge CLK) begin
+    rawSync0 <= raw;
+    rawSync1 <= rawSync0;
+    rawSync2 <= rawSync1;
+end
+wire [3:0] rise = rawSync1 & ~rawSync2;
+
+reg [WINDOW_BITS - 1:0] left0;
+reg [WINDOW_BITS - 1:0] left1;
+reg [WINDOW_BITS - 1:0] left2;
+reg [WINDOW_BITS - 1:0] left3;
+always @(posedge CLK) begin
+    left0 <= rise[0] && window != 0 ? window - 1 : left0 != 0 ? left0 - 1 : 0;
+    left1 <= rise[1] && window != 0 ? window - 1 : left1 != 0 ? left1 - 1 : 0;
+    left2 <= rise[2] && window != 0 ? window - 1 : left2 != 0 ? left2 - 1 : 0;
+    left3 <= rise[3] && window != 0 ? window - 1 : left3 != 0 ? left3 - 1 : 0;
+end
+wire [3:0] held = {left3 != 0, left2 != 0, left1 != 0, left0 != 0};
+wire [3:0] armed = window == 0 ? rawSync1 : rise | held;
+
+always @(posedge CLK) begin
+    out[0] <= threshold0 != 0 && hitCount(armed & mask0) >= threshold0;
+    out[1] <= threshold1 != 0 && hitCount(armed & mask1) >= threshold1;
+    out[2] <= threshold2 != 0 && hitCount(armed & mask2) >= threshold2;
+    out[3] <= threshold3 != 0 && hitCount(armed & mask3) >= threshold3;
+end
+
+endmodule
@@ -0,0 +1,145 @@
+// SPI slave (mode 0) for reading the latched counter bank, draining the
+// hit FIFO and programming the coincidence registers from the Pi.
+//
+// SS low for a command byte followed by 32-bit words, MSB first:
+//   MOSI  cmd  x             ...  x
+//   MISO  0    word0[31:24]  ...
+// cmd 0x01 latches every counter into the shadow bank at the end of the
+// command byte and reads the eight words; 0x02 reads the shadow bank again
+// unlatched, to retry a transfer. cmd 0x03 drains hitFifo: a status word
+// (11, bit 29 set as hits come with widths, bit 28 as the counter bank is
+// there, FIFO fill in bits 15-0), the
+// tick counter's low 32 bits at the end of the command byte, then queued
+// words for as long as SS stays low, padded with status words once the
+// FIFO is empty. cmd 0x04 writes the coincidence registers
+// (coincidenceRegs.v) from register 0 on, one word each, and they all take
+// effect when SS goes high, if all REGS words came in; a frame cut short
+// changes nothing. Register 0 is read-only and MISO carries the registers
+// as they were. cmd 0x05 reads them. Other commands read zeros.
+// SCK, SS and MOSI are sampled with CLK, so SCK must stay below CLK / 8
+// (1.2 MHz at 9.6 MHz, 6.25 MHz at 50 MHz).
+module counterSpi (
+    input CLK,
+    input SCK,
+    input SS,
+    input SDI,
+    output SDO,
+    output latch,
+    output [2:0] word,
+    input [31:0] shadow,
+    output pop,
+    input [31:0] fifoHead,
+    input fifoEmpty,
+    input [15:0] fifoFill,
+    input [31:0] fifoNow,
+    output regStage,
+    output regWrite,
+    output reg [2:0] regAddr,
+    output reg [31:0] regData,
+    output regCommit,
+    input [31:0] regs,
+);
+
+// 0 on bitstreams without hitFifo.v or the counter bank; without either,
+// drains read zeros, not a status word
+parameter HITS = 1;
+parameter BANK = 1;
+
+localparam CMD_LATCH_READ = 8'h01;
+localparam CMD_READ       = 8'h02;
+localparam CMD_DRAIN      = 8'h03;
+localparam CMD_WRITE_REGS = 8'h04;
+localparam CMD_READ_REGS  = 8'h05;
+localparam REGS           = 6;   // coincidenceRegs.v, a write covers all of them
+
+reg [2:0] sckSync;
+reg [1:0] ssSync;
+reg [1:0] sdiSync;
+always @(posedge CLK) begin
+    sckSync <= {sckSync[1:0], SCK};
+    ssSync  <= {ssSync[0], SS};
+    sdiSync <= {sdiSync[0], SDI};
+end
+
+wire sckRise = sckSync[2:1] == 2'b01;
+wire sckFall = sckSync[2:1] == 2'b10;
+wire active  = !ssSync[1];
+
+reg [15:0] bitCount;
+reg [6:0] rx;
+reg [7:0] cmd;
+reg latchPulse;
+reg popPulse;
+reg stagePulse;
+reg writePulse;
+reg commitPulse;
+reg [30:0] rxWord;
+reg [31:0] nowAtCmd;
+reg [31:0] tx;
+wire [7:0] rxByte = {rx, sdiSync[1]};
+wire [15:0] dataBits = bitCount - 16'd8;
+wire [31:0] status = HITS || BANK ? {2'b11, HITS != 0, BANK != 0, 12'b0, fifoFill} : 32'b0;
+always @(posedge CLK) begin
+    latchPulse  <= 0;
+    popPulse    <= 0;
+    stagePulse  <= 0;
+    writePulse  <= 0;
+    commitPulse <= 0;
+    if (!active) begin
+        // End of a complete register write, once
+        commitPulse <= cmd == CMD_WRITE_REGS && bitCount >= 8 + 32 * REGS;
+        bitCount    <= 0;
+        cmd         <= 0;
+        tx          <= 0;
+    end else if (sckRise) begin
+        if (bitCount < 7)
+            rx <= rxByte[6:0];
+        if (bitCount == 7) begin
+            cmd        <= rxByte;
+            latchPulse <= rxByte == CMD_LATCH_READ;
+            stagePulse <= rxByte == CMD_WRITE_REGS;
+            nowAtCmd   <= fifoNow;
+        end
+        if (bitCount >= 8) begin
+            rxWord <= {rxWord[29:0], sdiSync[1]};
+            if (dataBits[4:0] == 31 && cmd == CMD_WRITE_REGS && dataBits[15:8] == 0) begin
+                writePulse <= 1;
+                regAddr    <= dataBits[7:5];
+                regData    <= {rxWord, sdiSync[1]};
+            end
+        end
+        if (bitCount != 16'hFFFF)
+            bitCount <= bitCount + 1;
+    end else if (sckFall && bitCount >= 8) begin
+        // The shadow bank was latched a few CLKs after the 8th rising edge,
+        // each word is loaded before its first bit is sampled
+        if (dataBits[4:0] == 0) begin
+            if (cmd == CMD_LATCH_READ || cmd == CMD_READ)
+                tx <= shadow;
+            else if (cmd == CMD_READ_REGS || cmd == CMD_WRITE_REGS)
+                tx <= regs;
+            else if (cmd == CMD_DRAIN && dataBits[15:5] == 0)
+                tx <= status;
+            else if (cmd == CMD_DRAIN && dataBits[15:5] == 1)
+                tx <= nowAtCmd;
+            else if (cmd == CMD_DRAIN && !fifoEmpty) begin
+                tx       <= fifoHead;
+                popPulse <= 1;
+            end else if (cmd == CMD_DRAIN)
+                tx <= status;
+            else
+                tx <= 0;
+        end else
+            tx <= {tx[30:0], 1'b0};
+    end
+end
+
+assign SDO   = tx[31];
+assign latch = latchPulse;
+assign word  = dataBits[7:5];
+assign pop   = popPulse;
+assign regStage  = stagePulse;
+assign regWrite  = writePulse;
+assign regCommit = commitPulse;
+
+endmodule
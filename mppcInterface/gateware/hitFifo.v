@@ -0,0 +1,166 @@
+// Timestamped hits for the Pi, queued in block RAM.
+//
+// A free-running 54-bit tick counter runs on CLK (20 ns ticks with the
+// 50 MHz GPCLK). Every rising edge of a channel is stamped with it, the
+// pulse's time over threshold is counted in ticks until the falling edge,
+// and the pulse is then queued as two 32-bit words, back to back for the
+// channel:
+//   hit       00 ccc ttttttttttttttttttttttttttt   channel, tick bits 26-0
+//   width     01 1 cc 00000000000 wwwwwwwwwwwwwwww channel, ticks high
+//   epoch     01 0 eeeeeeeeeeeeeeeeeeeeeeeeeeeee  tick bits 53-25
+//   overflow  10 nnnnnnnnnnnnnnnnnnnnnnnnnnnnnn   hits dropped since the last one
+// An epoch word goes in every 2^25 ticks, so consecutive words are always
+// well within half the 2^27 range of a hit stamp and the Pi can rebuild
+// every stamp to 54 bits. A width saturates at 65535 ticks (1.3 ms), and a
+// pulse that long is queued then rather than at its end, so no stamp waits
+// long enough to be rebuilt wrong. Only epoch and overflow words can come
+// between a hit and its width.
+//
+// Each channel holds one pulse until the queue takes it, one word per CLK,
+// so hits on several channels in the same cycle keep their exact stamps. A
+// hit on a channel whose previous pulse is still waiting is dropped and
+// counted into the next overflow word.
+module hitFifo (
+    input CLK,
+    input [3:0] hits,
+    input pop,
+    output [31:0] head,
+    output empty,
+    output [15:0] fill,
+    output [31:0] now,
+);
+
+// 2^DEPTH_BITS words of 32 bits, 8 iCE40 RAM blocks (4 kbit) per 1024 words:
+// 2048 words fill a 1k part's 16, and the LP384 has none at all
+parameter DEPTH_BITS = 11;
+
+reg [53:0] ticks;
+always @(posedge CLK)
+    ticks <= ticks + 1;
+
+// Rising edges, stamped and held per channel
+reg [3:0] hitSync0;
+reg [3:0] hitSync1;
+reg [3:0] hitSync2;
+always @(posedge CLK) begin
+    hitSync0 <= hits;
+    hitSync1 <= hitSync0;
+    hitSync2 <= hitSync1;
+end
+wire [3:0] rise = hitSync1 & ~hitSync2;
+wire [3:0] fall = ~hitSync1 & hitSync2;
+
+// open: stamped, width counting. pending: ended, waiting for the queue.
+// widthNext: the hit word is in, the width word goes next.
+reg [3:0] open;
+reg [3:0] pending;
+reg [3:0] widthNext;
+reg [26:0] stamp0;
+reg [26:0] stamp1;
+reg [26:0] stamp2;
+reg [26:0] stamp3;
+reg [15:0] width0;
+reg [15:0] width1;
+reg [15:0] width2;
+reg [15:0] width3;
+wire [3:0] saturated = {&width3, &width2, &width1, &width0};
+wire [3:0] ended = open & (fall | saturated);
+reg markerPending;
+reg [28:0] marker;
+reg [29:0] lost;
+
+// Queue
+reg [31:0] mem [0:(1 << DEPTH_BITS) - 1];
+reg [DEPTH_BITS:0] wr;
+reg [DEPTH_BITS:0] wrSeen;   // wr a cycle late, so head is valid when !empty
+reg [DEPTH_BITS:0] rd;
+reg [31:0] headData;
+wire full = (wr - rd) == (1 << DEPTH_BITS);
+
+// One word per CLK: overflow, then epoch, then the width of the hit just
+// queued, then the lowest waiting channel's hit
+reg push;
+reg [31:0] pushWord;
+reg [3:0] taken;
+always @(*) begin
+    push     = !full;
+    taken    = 0;
+    pushWord = 0;
+    if (lost != 0)
+        pushWord = {2'b10, lost};
+    else if (markerPending)
+        pushWord = {2'b01, 1'b0, marker};
+    else if (widthNext[0]) begin
+        pushWord = {3'b011, 2'd0, 11'b0, width0};
+        taken    = 4'b0001;
+    end else if (widthNext[1]) begin
+        pushWord = {3'b011, 2'd1, 11'b0, width1};
+        taken    = 4'b0010;
+    end else if (widthNext[2]) begin
+        pushWord = {3'b011, 2'd2, 11'b0, width2};
+        taken    = 4'b0100;
+    end else if (widthNext[3]) begin
+        pushWord = {3'b011, 2'd3, 11'b0, width3};
+        taken    = 4'b1000;
+    end else if (pending[0]) begin
+        pushWord = {2'b00, 3'd0, stamp0};
+        taken    = 4'b0001;
+    end else if (pending[1]) begin
+        pushWord = {2'b00, 3'd1, stamp1};
+        taken    = 4'b0010;
+    end else if (pending[2]) begin
+        pushWord = {2'b00, 3'd2, stamp2};
+        taken    = 4'b0100;
+    end else if (pending[3]) begin
+        pushWord = {2'b00, 3'd3, stamp3};
+        taken    = 4'b1000;
+    end else
+        push = 0;
+end
+
+wire [3:0] pushed = push ? taken : 4'b0000;
+wire [3:0] retire = pushed & widthNext;
+wire [3:0] collide = rise & pending & ~retire;
+wire [3:0] start = rise & ~collide;
+wire [2:0] collideCount = collide[0] + collide[1] + collide[2] + collide[3];
+
+always @(posedge CLK) begin
+    open      <= (open & ~ended) | start;
+    pending   <= (pending & ~retire) | ended;
+    widthNext <= (widthNext | pushed) & ~retire;
+    if (start[0]) stamp0 <= ticks[26:0];
+    if (start[1]) stamp1 <= ticks[26:0];
+    if (start[2]) stamp2 <= ticks[26:0];
+    if (start[3]) stamp3 <= ticks[26:0];
+    width0 <= start[0] ? 16'd1 : open[0] && !ended[0] ? width0 + 1 : width0;
+    width1 <= start[1] ? 16'd1 : open[1] && !ended[1] ? width1 + 1 : width1;
+    width2 <= start[2] ? 16'd1 : open[2] && !ended[2] ? width2 + 1 : width2;
+    width3 <= start[3] ? 16'd1 : open[3] && !ended[3] ? width3 + 1 : width3;
+
+    if (ticks[24:0] == 0) begin
+        markerPending <= 1;
+        marker        <= ticks[53:25];
+    end else if (push && lost == 0 && markerPending)
+        markerPending <= 0;
+
+    if (push && lost != 0)
+        lost <= collideCount;
+    else
+        lost <= lost + collideCount;
+
+    if (push) begin
+        mem[wr[DEPTH_BITS - 1:0]] <= pushWord;
+        wr <= wr + 1;
+    end
+    wrSeen <= wr;
+    if (pop && !empty)
+        rd <= rd + 1;
+    headData <= mem[(pop && !empty ? rd + 1 : rd) & ((1 << DEPTH_BITS) - 1)];
+end
+
+assign head  = headData;
+assign empty = wrSeen == rd;
+assign fill  = wrSeen - rd;
+assign now   = ticks[31:0];
+
+endmodule
@@ -0,0 +1,26 @@
+// 32-bit rising edge counter with a shadow copy for the Pi to read.
+//
+// The input is synchronised to CLK, so highs and lows must each last one
+// CLK period (104 ns at 9.6 MHz, 20 ns at 50 MHz) and the count rate tops
+// out at CLK / 2. latch copies the running count into shadow on one CLK
+// edge; every counter in the bank shares it, so a bank read is a single
+// consistent snapshot and counting never stops for it. count is the running
+// value, for the telemetry frames.
+module latchedCounter (
+    input CLK,
+    input in,
+    input latch,
+    output reg [31:0] shadow,
+    output reg [31:0] count,
+);
+
+reg [2:0] inSync;
+always @(posedge CLK) begin
+    inSync <= {inSync[1:0], in};
+    if (inSync[2:1] == 2'b01)
+        count <= count + 1;
+    if (latch)
+        shadow <= count;
+end
+
+endmodule
@@ -2,7 +2,6 @@ module mppcInput (
     input analogIn,
     input booted,
     output digitalOut,
-    output [15:0] counter,
 );
 
 // Use hardmacro block for pin initializtion
@@ -16,7 +15,4 @@ SB_IO #(
     .D_IN_0(digitalOut)
 );
 
-always @(posedge digitalOut)
-    counter = counter + 1;
-
 endmodule
\ No newline at end of file
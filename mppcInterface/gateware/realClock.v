@@ -1,4 +1,6 @@
-module realClock (
+module realClock #(
+    parameter CYCLES_PER_MS = 9600
+) (
     input CLK,
     output ms,
     output sec,
@@ -8,7 +10,7 @@ module realClock (
     output minutePulse,
 );
 
-reg [12:0] timer0;     // At 9.6Mhz, 1ms is 9600 cycles, fits in 2^13
+reg [15:0] timer0;     // At 9.6Mhz, 1ms is 9600 cycles, 50000 at 50 MHz
 reg [9:0] timer1;      // At 1.0Khz, 1s  is 1000 cycles, fits in 2^10
 reg [5:0] timer2;      // At 1   hz, 1m  is 60   cylces, fits in 2^6
 reg minute;            // Single bit minute info
@@ -20,7 +22,7 @@ reg _minutePulse;       // Single bit minute info
 // Count up in ms
 always @(posedge CLK)
 begin
-    if (timer0 < 4799) begin
+    if (timer0 < CYCLES_PER_MS - 1) begin
         timer0 = timer0 + 1;
         _msPulse = 0;
         _secPulse = 0;
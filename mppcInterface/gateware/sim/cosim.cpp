@@ -0,0 +1,515 @@
+// cosim.cpp — top.v as a Verilator model under the Pi's own FPGA drivers
+// - One process, one clock: every CLK cycle drives CH0-CH3 from the pulse
+//   stimulus, steps the model and follows its Pi-facing outputs
+// - The SPI pins go through SimHal (../firmware/libraries/hal): the real
+//   ICE40 upload, FpgaCounters, FpgaHits and FpgaCoincidences talk to a
+//   device that clocks their bytes into gpioSCK/gpioSDO cycle by cycle
+// - A C++ reference of the inputs and coincidenceRegs.v keeps the truth:
+//   every bank word, every hit's tick and width, every telemetry frame is
+//   checked
+// - gpio27/18/17 feed the slowControl edge handlers through inject(), with
+//   an interrupt dead time, for the host's loss against the FPGA
+// Build: make sim (from gateware/)
+// Usage: ./build/sim/cosim [-s seconds] [-D dark_hz] [-M muon_hz] [-w dark_ns] [-W muon_ns]
+//                          [-j jitter_ns] [-p pi_dead_ns] [-r read_ms] [-d drain_ms]
+//                          [-t cut_ns] [-c layout.conf] [-b bitstream] [-S seed]
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <algorithm>
+#include <unistd.h>
+
+#include "Vtop.h"
+#include "verilated.h"
+
+#include "hal.h"
+#include "ice40.h"
+#include "channelMap.h"
+#include "counterBank.h"
+#include "fpgaCounters.h"
+#include "fpgaCoincidences.h"
+#include "fpgaHits.h"
+#include "telemetry.h"
+#include "stimulus.h"
+
+#define CLK_HZ          50000000     // top.v CLK_HZ
+#define BOOT_CYCLES     (1 << 17)    // past top.v's bootTimeout
+#define SETTLE_CYCLES   64           // inputs to counters, every sync stage
+#define UART_BAUD       115200
+#define ICE40_DONE_PIN  23
+#define ICE40_RST_PIN   22
+#define PI_PINS         3
+#define DRAIN_MAX       (4 * FPGA_HIT_BURST)
+
+static const unsigned PI_BCM[PI_PINS] = {27, 18, 17};   // coinc[0..2], top.v
+
+static Vtop *top;
+static uint64_t cycle = 0;
+static uint64_t stimStart = 0;
+static uint64_t stimEnd = 0;
+static PulseStimulus *stimulus;
+
+// One CLK cycle of the model, and everything that watches it
+static void tick();
+
+static void run(uint64_t cycles) {
+  for (uint64_t i = 0; i < cycles; i++) tick();
+}
+
+// ---- Reference: the stimulus as the gateware should count it ------------
+static struct Reference {
+  FpgaLayout layout;
+  uint8_t prev;
+  uint8_t coincPrev;
+  uint16_t left[FPGA_COINC_CHANNELS];
+  uint64_t words[FPGA_BANK_WORDS];          // rising edges, bank word order
+  bool track;                               // keep pulses for the hit match
+  struct Pulse {
+    uint64_t rise;
+    uint32_t width;                         // cycles high, once it fell
+  };
+  std::deque<Pulse> pulses[FPGA_HIT_CHANNELS];
+
+  // Mirrors coincidenceRegs.v on the synchronised levels
+  void step(uint8_t levels) {
+    uint8_t rise = levels & ~prev;
+    uint8_t held = 0;
+    for (int c = 0; c < FPGA_COINC_CHANNELS; c++) held |= (left[c] != 0) << c;
+    uint8_t armed = layout.window == 0 ? levels : rise | held;
+    uint8_t fall = ~levels & prev;
+    for (int c = 0; c < FPGA_COINC_CHANNELS; c++) {
+      bool r = rise >> c & 1;
+      left[c] = r && layout.window ? layout.window - 1 : left[c] ? left[c] - 1 : 0;
+      std::deque<Pulse> &q = pulses[c];
+      if (fall >> c & 1 && !q.empty() && q.back().width == 0) q.back().width = cycle - q.back().rise;
+      if (!r) continue;
+      words[c]++;
+      if (track) q.push_back(Pulse{cycle, 0});
+    }
+    uint8_t coinc = 0;
+    for (int o = 0; o < FPGA_COINC_OUTPUTS; o++) {
+      const FpgaCoincidence &out = layout.outputs[o];
+      unsigned bits = 0;
+      for (uint8_t m = armed & out.mask; m; m >>= 1) bits += m & 1;
+      if (out.threshold && bits >= out.threshold) coinc |= 1 << o;
+    }
+    for (int o = 0; o < FPGA_COINC_OUTPUTS; o++)
+      if ((coinc & ~coincPrev) >> o & 1) words[FPGA_COINC_CHANNELS + o]++;
+    prev      = levels;
+    coincPrev = coinc;
+  }
+} ref;
+
+// ---- Pi side: slowControl's counters behind an interrupt dead time ------
+static CounterBank<CHANNEL_COUNT> piCounters;
+
+template <size_t I> struct PiEdge {
+  static void edge() { piCounters.increment(I); }
+  static void timed(uint64_t) { piCounters.increment(I); }
+};
+typedef ChannelHandlers<PiEdge> PiHandlers;
+
+static struct PiPin {
+  uint8_t level;
+  bool fired;
+  uint64_t lastCycle;       // of the last edge the handler took
+  uint64_t edges;           // on the pin
+  uint64_t taken;           // handed to the handler
+} piPins[PI_PINS];
+static uint64_t piDeadCycles = 0;
+
+static void watchPi() {
+  const uint8_t levels[PI_PINS] = {top->gpio27, top->gpio18, top->gpio17};
+  for (int p = 0; p < PI_PINS; p++) {
+    PiPin &pin = piPins[p];
+    if (levels[p] && !pin.level) {
+      pin.edges++;
+      if (!pin.fired || cycle - pin.lastCycle >= piDeadCycles) {
+        hal().inject(PI_BCM[p]);
+        pin.fired     = true;
+        pin.lastCycle = cycle;
+        pin.taken++;
+      }
+    }
+    pin.level = levels[p];
+  }
+}
+
+// ---- UART receiver on uartTx, checked against the reference -------------
+#define UART_RING 64        // byte start snapshots, more than a frame
+
+static struct UartRx {
+  double bitCycles;
+  bool busy;
+  uint64_t start;
+  int bit;
+  uint8_t byte;
+  uint8_t line;
+  uint64_t bytes;
+  uint64_t snapshots[UART_RING][FPGA_BANK_WORDS];
+  uint64_t inBounds;
+  uint64_t outOfBounds;
+} uartRx;
+
+static void onTelemetry(const TelemetryFrame &frame, void *ctx) {
+  (void)ctx;
+  // The frame's counts were taken between its first byte and now
+  const uint64_t *before = uartRx.snapshots[(uartRx.bytes - TELEMETRY_FRAME_BYTES) % UART_RING];
+  bool ok = true;
+  for (int w = 0; w < TELEMETRY_WORDS; w++)
+    ok = ok && frame.counts[w] >= (uint32_t)before[w] && frame.counts[w] <= (uint32_t)ref.words[w];
+  if (ok) {
+    uartRx.inBounds++;
+  } else {
+    uartRx.outOfBounds++;
+    std::fprintf(stderr, "telemetry frame %u outside the reference counts\n", frame.seq);
+  }
+}
+
+static TelemetryDecoder telemetry(onTelemetry, NULL);
+
+static void watchUart() {
+  UartRx &rx = uartRx;
+  uint8_t line = top->uartTx;
+  if (!rx.busy) {
+    if (rx.line && !line) {
+      rx.busy  = true;
+      rx.start = cycle;
+      rx.bit   = 0;
+      rx.byte  = 0;
+      std::memcpy(rx.snapshots[rx.bytes % UART_RING], ref.words, sizeof(ref.words));
+    }
+  } else if (cycle >= rx.start + (uint64_t)((1.5 + rx.bit) * rx.bitCycles)) {
+    // Data bits LSB first at their middles, then the stop bit
+    if (rx.bit < 8) {
+      rx.byte |= line << rx.bit;
+      rx.bit++;
+    } else {
+      rx.busy = false;
+      rx.bytes++;
+      if (line) telemetry.feed(&rx.byte, 1);
+    }
+  }
+  rx.line = line;
+}
+
+static void tick() {
+  uint8_t levels = cycle >= stimStart && cycle < stimEnd ? stimulus->levels(cycle) : 0;
+  top->CH0 = levels & 1;
+  top->CH1 = levels >> 1 & 1;
+  top->CH2 = levels >> 2 & 1;
+  top->CH3 = levels >> 3 & 1;
+  ref.step(levels);
+
+  top->CLK = 1;
+  top->eval();
+  top->CLK = 0;
+  top->eval();
+  cycle++;
+
+  watchPi();
+  watchUart();
+}
+
+// ---- SPI device: the upload, then mode 0 into the model -----------------
+static struct SpiDevice {
+  bool configured;
+  uint64_t bitstreamBytes;
+  uint32_t halfBitCycles;
+  uint64_t transfers;
+  uint64_t cycles;          // of the last transfer
+  uint64_t longest;         // cycles the port was held at most
+} spi;
+
+static void spiDevice(uint8_t channel, uint8_t *data, size_t len, void *ctx) {
+  (void)channel;
+  (void)ctx;
+  if (!spi.configured) {
+    // The model is top.v as built: the bitstream is only counted, and the
+    // flush clocks after it (CS high) complete the configuration
+    if (hal().digitalRead(FPGA_CS_PIN) == 0) {
+      spi.bitstreamBytes += len;
+    } else if (spi.bitstreamBytes) {
+      spi.configured = true;
+      hal().scriptInput(ICE40_DONE_PIN, 1, hal().now_us());
+    }
+    std::memset(data, 0, len);
+    return;
+  }
+
+  uint64_t begin = cycle;
+  top->gpioSS = 0;
+  run(spi.halfBitCycles);
+  for (size_t i = 0; i < len; i++) {
+    uint8_t in = 0;
+    for (int b = 7; b >= 0; b--) {
+      top->gpioSDO = data[i] >> b & 1;
+      run(spi.halfBitCycles);
+      top->gpioSCK = 1;
+      in = in << 1 | (top->gpioSDI & 1);
+      run(spi.halfBitCycles);
+      top->gpioSCK = 0;
+    }
+    data[i] = in;
+  }
+  run(spi.halfBitCycles);
+  top->gpioSS = 1;
+  run(spi.halfBitCycles);
+  spi.transfers++;
+  spi.cycles = cycle - begin;
+  spi.longest = std::max(spi.longest, spi.cycles);
+}
+
+// ---- Hits against the reference pulses ----------------------------------
+static struct HitMatch {
+  bool latencyKnown;
+  int64_t latency;          // FPGA tick - stimulus cycle, constant
+  uint64_t exact;
+  uint64_t wrong;           // no reference rise at the expected tick
+  uint64_t missing;         // reference rises no hit came for
+  uint64_t widthExact;
+  uint64_t widthWrong;
+} match;
+
+static void matchHits(const FpgaHit *hits, int n) {
+  for (int i = 0; i < n; i++) {
+    std::deque<Reference::Pulse> &q = ref.pulses[hits[i].channel & 3];
+    bool found = false;
+    uint32_t width = 0;
+    while (!q.empty() && !found) {
+      int64_t offset = (int64_t)hits[i].ticks - (int64_t)q.front().rise;
+      if (!match.latencyKnown) {
+        match.latency      = offset;
+        match.latencyKnown = true;
+      }
+      if (offset > match.latency) {
+        q.pop_front();
+        match.missing++;
+      } else {
+        found = offset == match.latency;
+        if (found) width = q.front().width;
+        if (found) q.pop_front();
+        break;
+      }
+    }
+    if (found) match.exact++;
+    else match.wrong++;
+    // Widths saturate in the FPGA, and a pulse that long goes out before
+    // it ends
+    if (found && hits[i].width) {
+      if (hits[i].width == FPGA_WIDTH_MAX ? width == 0 || width >= FPGA_WIDTH_MAX : hits[i].width == width)
+        match.widthExact++;
+      else
+        match.widthWrong++;
+    }
+  }
+}
+
+static void usage(const char *argv0) {
+  std::fprintf(stderr,
+               "Usage: %s [-s seconds] [-D dark_hz] [-M muon_hz] [-w dark_ns] [-W muon_ns]\n"
+               "          [-j jitter_ns] [-p pi_dead_ns] [-r read_ms] [-d drain_ms]\n"
+               "          [-t cut_ns] [-c layout.conf] [-b bitstream] [-S seed]\n",
+               argv0);
+}
+
+int main(int argc, char **argv) {
+  double seconds = 2.0;
+  StimulusConfig config = {2000.0, 100.0, 0, 0, 0, 1};
+  double darkNs = 60, muonNs = 200, jitterNs = 40, piDeadNs = 10000;
+  double readMs = 100, drainMs = 100, cutNs = 0;
+  const char *layoutPath = NULL;
+  const char *bitstream = "../firmware/libraries/ice40/top_50MHz_300_60.bin";
+
+  Verilated::commandArgs(argc, argv);
+  int opt;
+  while ((opt = getopt(argc, argv, "s:D:M:w:W:j:p:r:d:t:c:b:S:h")) != -1) {
+    switch (opt) {
+      case 's': seconds = std::atof(optarg); break;
+      case 'D': config.darkHz = std::atof(optarg); break;
+      case 'M': config.muonHz = std::atof(optarg); break;
+      case 'w': darkNs = std::atof(optarg); break;
+      case 'W': muonNs = std::atof(optarg); break;
+      case 'j': jitterNs = std::atof(optarg); break;
+      case 'p': piDeadNs = std::atof(optarg); break;
+      case 'r': readMs = std::atof(optarg); break;
+      case 'd': drainMs = std::atof(optarg); break;
+      case 't': cutNs = std::atof(optarg); break;
+      case 'c': layoutPath = optarg; break;
+      case 'b': bitstream = optarg; break;
+      case 'S': config.seed = std::strtoull(optarg, NULL, 0); break;
+      default: usage(argv[0]); return opt == 'h' ? 0 : 1;
+    }
+  }
+  if (seconds <= 0 || readMs <= 0 || drainMs <= 0) {
+    usage(argv[0]);
+    return 1;
+  }
+  const double nsPerCycle = 1e9 / CLK_HZ;
+  config.darkCycles   = std::max(1.0, darkNs / nsPerCycle);
+  config.muonCycles   = std::max(1.0, muonNs / nsPerCycle);
+  config.jitterCycles = jitterNs / nsPerCycle;
+  piDeadCycles        = piDeadNs / nsPerCycle;
+
+  FpgaLayout layout = fpgaDefaultLayout();
+  if (layoutPath && !loadFpgaLayout(layoutPath, layout)) return 1;
+
+  // No Poisson edges from SimHal itself, the model makes them
+  unsetenv("SIMHAL_EDGE_HZ");
+  top = new Vtop;
+  top->gpioSS  = 1;
+  top->gpioSCK = 0;
+  top->gpioSDO = 0;
+  top->CLK     = 0;
+  top->eval();
+  uartRx.line      = 1;
+  uartRx.bitCycles = (double)CLK_HZ / UART_BAUD;
+  spi.halfBitCycles = std::max(1, CLK_HZ / FPGA_SPI_HZ / 2);
+  ref.layout = fpgaDefaultLayout();
+
+  hal().setup();
+  hal().spiAttach(0, spiDevice, NULL);
+  hal().scriptInput(ICE40_DONE_PIN, 0, 0);
+  for (size_t i = 0; i < CHANNEL_COUNT; i++)
+    for (int p = 0; p < PI_PINS; p++)
+      if (CHANNEL_MAP[i].bcm == PI_BCM[p]) hal().onRisingEdge(CHANNEL_MAP[i].bcm, PiHandlers::edges()[i]);
+
+  ICE40 fpga(FPGA_CS_PIN, ICE40_DONE_PIN, ICE40_RST_PIN, 0);
+  fpga.configure(bitstream);
+  if (!spi.configured) {
+    std::fprintf(stderr, "The upload never finished, no model to run\n");
+    return 1;
+  }
+  run(BOOT_CYCLES);
+
+  FpgaCounters bank;
+  FpgaHits hits;
+  FpgaCoincidences regs;
+  if (!bank.open() || !hits.open() || !regs.open()) return 1;
+  if (!regs.write(layout)) return 1;
+  hits.setCut(std::min<double>(std::ceil(cutNs / FPGA_TICK_NS), FPGA_WIDTH_MAX));
+  ref.layout = layout;
+  printFpgaLayout(stdout, layout);
+
+  static const uint8_t ALL_WORDS[FPGA_BANK_WORDS] = {0, 1, 2, 3, 4, 5, 6, 7};
+  uint64_t deltas[FPGA_BANK_WORDS];
+  uint64_t fpgaWords[FPGA_BANK_WORDS] = {0};
+  if (!bank.deltas(ALL_WORDS, FPGA_BANK_WORDS, deltas)) return 1;
+  uint64_t readCycles = spi.cycles;
+
+  static FpgaHit drained[DRAIN_MAX];
+  while (hits.drain(drained, DRAIN_MAX) > 0) {}
+  uint64_t drainCycles = spi.cycles;
+  // A full burst: command, status, tick and FPGA_HIT_BURST words
+  uint64_t burstCycles = ((1 + 4 * (2 + FPGA_HIT_BURST)) * 16 + 3) * (uint64_t)spi.halfBitCycles;
+  uint64_t startWords[FPGA_BANK_WORDS];
+  std::memcpy(startWords, ref.words, sizeof(startWords));
+
+  // Stimulus from here on, every pulse tracked for the hit match
+  PulseStimulus pulses(config, CLK_HZ);
+  stimulus  = &pulses;
+  ref.track = true;
+  stimStart = cycle;
+  stimEnd   = cycle + (uint64_t)(seconds * CLK_HZ);
+  const uint64_t readEvery  = readMs * CLK_HZ / 1000;
+  const uint64_t drainEvery = drainMs * CLK_HZ / 1000;
+  uint64_t nextRead  = cycle + readEvery;
+  uint64_t nextDrain = cycle + drainEvery;
+  uint64_t reads = 0, drains = 0, late = 0;
+  uint32_t maxFill = 0;
+  auto wallStart = std::chrono::steady_clock::now();
+
+  for (bool last = false; !last;) {
+    uint64_t until = std::min(std::min(nextRead, nextDrain), stimEnd);
+    if (until > cycle) run(until - cycle);
+    last = cycle >= stimEnd;
+    if (last) run(SETTLE_CYCLES);
+
+    if (cycle >= nextDrain || last) {
+      int n;
+      do {
+        n = hits.drain(drained, DRAIN_MAX);
+        if (n < 0) return 1;
+        matchHits(drained, n);
+        maxFill = std::max(maxFill, hits.fill());
+        drains++;
+      } while (last && n > 0);
+      nextDrain += drainEvery;
+      if (nextDrain <= cycle) {
+        late++;
+        nextDrain = cycle;
+      }
+    }
+    if (cycle >= nextRead || last) {
+      if (!bank.deltas(ALL_WORDS, FPGA_BANK_WORDS, deltas)) return 1;
+      for (int w = 0; w < FPGA_BANK_WORDS; w++) fpgaWords[w] += deltas[w];
+      reads++;
+      nextRead = std::max(cycle, nextRead + readEvery);
+    }
+    hal().clearLogs();
+  }
+  for (int c = 0; c < FPGA_HIT_CHANNELS; c++) match.missing += ref.pulses[c].size();
+  double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+  // ---- Report ----
+  uint64_t simCycles = cycle - stimStart;
+  double simSeconds  = (double)simCycles / CLK_HZ;
+  std::printf("\n%llu cycles (%.3f s at %d MHz) in %.1f s, %.2f M cycles/s\n", (unsigned long long)simCycles,
+              simSeconds, CLK_HZ / 1000000, wall, simCycles / wall / 1e6);
+  std::printf("stimulus: %llu dark pulses, %llu muons, bitstream %llu bytes\n",
+              (unsigned long long)pulses.darkPulses(), (unsigned long long)pulses.muons(),
+              (unsigned long long)spi.bitstreamBytes);
+
+  bool ok = true;
+  std::printf("\n%-6s %12s %12s %8s\n", "word", "reference", "fpga", "diff");
+  for (int w = 0; w < FPGA_BANK_WORDS; w++) {
+    uint64_t expect = ref.words[w] - startWords[w];
+    std::printf("%-6d %12llu %12llu %8lld\n", w, (unsigned long long)expect, (unsigned long long)fpgaWords[w],
+                (long long)(fpgaWords[w] - expect));
+    ok = ok && fpgaWords[w] == expect;
+  }
+
+  std::printf("\nhits: %llu exact at +%lld ticks, %llu wrong, %llu missing, %llu dropped in the FPGA\n",
+              (unsigned long long)match.exact, (long long)match.latency, (unsigned long long)match.wrong,
+              (unsigned long long)match.missing, (unsigned long long)hits.lost());
+  std::printf("      max fill %u of 2048, %.1f hits/s\n", maxFill, match.exact / simSeconds);
+  std::printf("      widths %llu exact, %llu wrong, %llu hits below the cut\n", (unsigned long long)match.widthExact,
+              (unsigned long long)match.widthWrong, (unsigned long long)hits.cut());
+  ok = ok && match.wrong == 0 && match.widthWrong == 0 && match.missing == hits.lost() + hits.cut();
+
+  std::printf("\nspi at %d Hz: bank read %llu cycles (%.1f us), empty drain %llu cycles (%.1f us),\n", FPGA_SPI_HZ,
+              (unsigned long long)readCycles, readCycles * nsPerCycle / 1000, (unsigned long long)drainCycles,
+              drainCycles * nsPerCycle / 1000);
+  std::printf("     longest transfer %llu cycles (%.2f ms)\n", (unsigned long long)spi.longest,
+              spi.longest * nsPerCycle / 1e6);
+  std::printf("     %llu reads, %llu drains (%llu late), drain sustains %.0f hits/s\n", (unsigned long long)reads,
+              (unsigned long long)drains, (unsigned long long)late,
+              FPGA_HIT_BURST / ((drainCycles + burstCycles) * nsPerCycle / 1e9));
+
+  std::printf("\n%-16s %-6s %10s %10s %8s %10s\n", "pi input", "gpio", "fpga", "pi", "loss", "correction");
+  for (size_t i = 0; i < CHANNEL_COUNT; i++) {
+    for (int p = 0; p < PI_PINS; p++) {
+      if (CHANNEL_MAP[i].bcm != PI_BCM[p]) continue;
+      uint64_t fpgaCount = fpgaWords[FPGA_COINC_CHANNELS + p];
+      uint64_t piCount   = piCounters.peek(i);
+      LossEstimate e     = estimateLoss(piCount, fpgaCount, simSeconds);
+      std::printf("%-16s %-6u %10llu %10llu %7.3f%% %10.4f\n", CHANNEL_MAP[i].name, PI_BCM[p],
+                  (unsigned long long)fpgaCount, (unsigned long long)piCount, 100 * e.loss, e.correction);
+      ok = ok && piCount == piPins[p].taken;
+    }
+  }
+
+  std::printf("\nuart: %llu frames in bounds, %llu out, %llu crc errors, %llu missed\n",
+              (unsigned long long)uartRx.inBounds, (unsigned long long)uartRx.outOfBounds,
+              (unsigned long long)telemetry.crcErrors(), (unsigned long long)telemetry.missed());
+  ok = ok && uartRx.outOfBounds == 0 && telemetry.crcErrors() == 0;
+
+  std::printf("\n%s\n", ok ? "PASS" : "FAIL");
+  top->final();
+  delete top;
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,18 @@
+// Behavioural stand-ins for the iCE40 cells top.v uses, for Verilator only
+// (yosys maps the real ones).
+//
+// SB_IO: the stimulus drives the pad, so D_IN_0 follows PACKAGE_PIN and the
+// output driver is not modelled.
+module SB_IO #(
+    parameter PIN_TYPE = 6'b000000,
+    parameter PULLUP = 1'b0
+) (
+    input PACKAGE_PIN,
+    input OUTPUT_ENABLE,
+    input D_OUT_0,
+    output D_IN_0
+);
+
+assign D_IN_0 = PACKAGE_PIN;
+
+endmodule
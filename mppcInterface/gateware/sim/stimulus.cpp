@@ -0,0 +1,61 @@
+// stimulus.cpp — Poisson dark and muon pulse trains, one cycle at a time
+// - Arrivals drawn as exponential gaps in cycles, 0 Hz never fires
+// - Pulses queue per channel by start cycle; the level is high up to the
+//   latest end of every pulse started so far
+// Build: make sim (from gateware/)
+
+#include <algorithm>
+#include <cmath>
+
+#include "stimulus.h"
+
+#define NEVER UINT64_MAX
+
+PulseStimulus::PulseStimulus(const StimulusConfig &config, double clkHz) : _rng(config.seed) {
+  _config     = config;
+  _clkHz      = clkHz;
+  _darkPulses = 0;
+  _muons      = 0;
+  for (int c = 0; c < STIMULUS_CHANNELS; c++) {
+    _nextDark[c]  = gap(config.darkHz);
+    _highUntil[c] = 0;
+  }
+  _nextMuon = gap(config.muonHz);
+}
+
+uint64_t PulseStimulus::gap(double rateHz) {
+  if (rateHz <= 0) return NEVER;
+  std::exponential_distribution<double> cycles(rateHz / _clkHz);
+  return 1 + (uint64_t)cycles(_rng);
+}
+
+uint8_t PulseStimulus::levels(uint64_t cycle) {
+  if (cycle >= _nextMuon) {
+    std::normal_distribution<double> width(_config.muonCycles, 0.1 * _config.muonCycles);
+    std::uniform_int_distribution<uint32_t> jitter(0, _config.jitterCycles);
+    for (int c = 0; c < STIMULUS_CHANNELS; c++) {
+      Pulse p = {cycle + jitter(_rng), (uint32_t)std::max(1.0, std::round(width(_rng)))};
+      _pending[c].push(p);
+    }
+    _muons++;
+    _nextMuon = cycle + gap(_config.muonHz);
+  }
+
+  uint8_t out = 0;
+  for (int c = 0; c < STIMULUS_CHANNELS; c++) {
+    if (cycle >= _nextDark[c]) {
+      std::exponential_distribution<double> width(1.0 / std::max<uint32_t>(_config.darkCycles, 1));
+      Pulse p = {cycle, 1 + (uint32_t)width(_rng)};
+      _pending[c].push(p);
+      _darkPulses++;
+      _nextDark[c] = cycle + gap(_config.darkHz);
+    }
+    PulseQueue &q = _pending[c];
+    while (!q.empty() && q.top().start <= cycle) {
+      _highUntil[c] = std::max(_highUntil[c], q.top().start + q.top().width);
+      q.pop();
+    }
+    if (cycle < _highUntil[c]) out |= 1 << c;
+  }
+  return out;
+}
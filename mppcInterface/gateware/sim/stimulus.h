@@ -0,0 +1,59 @@
+// Pulse trains for the analog channel inputs of the co-simulation.
+//
+// Each channel gets its own Poisson dark pulses, short and exponentially
+// distributed in width, and every channel gets the same muon pulses, wider
+// and a few cycles apart. Pulses overlapping on a channel merge into one
+// high level, as the comparator would make them. Levels are produced one
+// CLK cycle at a time, so every high and low lasts at least a cycle.
+#ifndef __STIMULUS_H__
+#define __STIMULUS_H__
+
+#include <stdint.h>
+#include <queue>
+#include <random>
+#include <vector>
+
+#define STIMULUS_CHANNELS 4
+
+struct StimulusConfig {
+  double darkHz;          // per channel
+  double muonHz;          // on every channel at once
+  uint32_t darkCycles;    // mean dark pulse width
+  uint32_t muonCycles;    // mean muon pulse width, +-10 %
+  uint32_t jitterCycles;  // spread of a muon's start across channels
+  uint64_t seed;
+};
+
+class PulseStimulus {
+ public:
+  PulseStimulus(const StimulusConfig &config, double clkHz);
+
+  // Levels of CH0..CH3, bit n, for cycle; cycles must come in order
+  uint8_t levels(uint64_t cycle);
+
+  uint64_t darkPulses() const { return _darkPulses; }
+  uint64_t muons() const { return _muons; }
+
+ private:
+
+  struct Pulse {
+    uint64_t start;
+    uint32_t width;
+    bool operator>(const Pulse &other) const { return start > other.start; }
+  };
+  typedef std::priority_queue<Pulse, std::vector<Pulse>, std::greater<Pulse> > PulseQueue;
+
+  uint64_t gap(double rateHz);
+
+  StimulusConfig _config;
+  double _clkHz;
+  std::mt19937_64 _rng;
+  uint64_t _nextDark[STIMULUS_CHANNELS];
+  uint64_t _nextMuon;
+  uint64_t _highUntil[STIMULUS_CHANNELS];
+  PulseQueue _pending[STIMULUS_CHANNELS];
+  uint64_t _darkPulses;
+  uint64_t _muons;
+};
+
+#endif //__STIMULUS_H__
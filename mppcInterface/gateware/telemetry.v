@@ -0,0 +1,101 @@
+// Once-a-second telemetry frame for the Pi on the UART.
+//
+// Frame, 39 bytes, fields MSB first:
+//   0xA5 0x5A   sync
+//   seq         16 bits, one more every frame
+//   n           number of counts, 8
+//   count x n   running 32-bit counts of the counter bank (latchedCounter.v)
+//   crc         CRC-16/CCITT-FALSE of seq, n and the counts
+// Counts are cumulative, each taken as its first byte goes out, so the Pi
+// gets exact per-second differences channel by channel and a lost or
+// corrupt frame loses no counts.
+module telemetry (
+    input CLK,
+    input rst,
+    input start,
+    output [2:0] word,
+    input [31:0] count,
+    input busy,
+    output reg wr,
+    output reg [7:0] data,
+);
+
+localparam FRAME_BYTES = 39;
+
+function [15:0] crc16;
+    input [15:0] crc;
+    input [7:0] b;
+    integer i;
+    reg [15:0] c;
+    begin
+        c = crc ^ {b, 8'h00};
+        for (i = 0; i < 8; i = i + 1)
+            c = c[15] ? {c[14:0], 1'b0} ^ 16'h1021 : {c[14:0], 1'b0};
+        crc16 = c;
+    end
+endfunction
+
+reg sending;
+reg waitBusy;
+reg [5:0] index;
+reg [15:0] seq;
+reg [15:0] crc;
+reg [23:0] hold;
+wire [5:0] countByte = index - 6'd5;
+
+reg [7:0] next;
+always @(*) begin
+    case (index)
+        6'd0:  next = 8'hA5;
+        6'd1:  next = 8'h5A;
+        6'd2:  next = seq[15:8];
+        6'd3:  next = seq[7:0];
+        6'd4:  next = 8'd8;
+        6'd37: next = crc[15:8];
+        6'd38: next = crc[7:0];
+        default:
+            case (countByte[1:0])
+                2'd0: next = count[31:24];
+                2'd1: next = hold[23:16];
+                2'd2: next = hold[15:8];
+                default: next = hold[7:0];
+            endcase
+    endcase
+end
+
+always @(posedge CLK) begin
+    wr <= 0;
+    if (rst) begin
+        sending  <= 0;
+        waitBusy <= 0;
+        seq      <= 0;
+    end else if (!sending) begin
+        if (start) begin
+            sending  <= 1;
+            waitBusy <= 0;
+            index    <= 0;
+            crc      <= 16'hFFFF;
+        end
+    end else if (waitBusy) begin
+        // uart takes the byte on wr and raises busy the next cycle
+        if (busy)
+            waitBusy <= 0;
+    end else if (!busy && !wr) begin
+        data     <= next;
+        wr       <= 1;
+        waitBusy <= 1;
+        if (index >= 2 && index < 37)
+            crc <= crc16(crc, next);
+        if (index >= 5 && index < 37 && countByte[1:0] == 0)
+            hold <= count[23:0];
+        if (index == FRAME_BYTES - 1) begin
+            sending <= 0;
+            seq     <= seq + 1;
+        end
+        index <= index + 1;
+    end
+end
+
+assign word = countByte[4:2];
+
+endmodule
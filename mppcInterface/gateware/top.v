@@ -11,23 +11,27 @@ module top (
     input CH7,
     input CLK,  
     input gpioSDO,
-    input gpioSDI,
+    output gpioSDI,
     input gpioSCK,
     input gpioSS,
     output LED0,
     output LED1,
     output LED2,
     output gpio27,  
-    output gpio23,  
     output gpio18,  
     output gpio17,
+`ifndef LP384
+    output uartTx,
+`endif
         );
 
+    // Must match the GPCLK rc.local sets on the Pi's GPIO4
+    localparam CLK_HZ = 50000000;
+
     wire CH0_R;
     wire CH1_R;
     wire CH2_R;
     wire CH3_R;
-    reg [7:0] eventCount [15:0];
     reg [3:0] eventSel;
     reg sendingByte;
     reg [24:0] bootTimer = 0;
@@ -50,7 +54,7 @@ module top (
         end
     end
 
-    // CLK is at 9.6Mhz set in FPGA binary upload code
+    // CLK is 9.6 MHz while the bitstream uploads, then rc.local sets CLK_HZ
     always @(posedge CLK)
         bootTimer = bootTimer + 1;
 
@@ -58,61 +62,199 @@ module top (
         .analogIn   (CH0),
         .booted     (booted),
         .digitalOut (CH0_R),
-        .counter    (eventCount[0]),
     );
     mppcInput CHANNEL1(
         .analogIn  (CH1),
         .booted    (booted),
         .digitalOut (CH1_R),
-        .counter    (eventCount[1]),
     );
     mppcInput CHANNEL2(
         .analogIn  (CH2),
         .booted    (booted),
         .digitalOut (CH2_R),
-        .counter    (eventCount[2]),
     );
     mppcInput CHANNEL3(
         .analogIn  (CH3),
         .booted    (booted),
         .digitalOut (CH3_R),
-        .counter    (eventCount[3]),
     );
 
-    // wire pulse;
-    // realClock real0(
-    //     .CLK    (CLK),
-    //     .secPulse (pulse),
-    // );
-
-    // reg uartBusy;
-    // wire [7:0] data;
-    // wire retransmit;
-    // uart UART0(
-    //     .uart_busy    (uartBusy), 
-    //     .uart_tx      (gpio17),   
-    //     .uart_wr_i    (pulse | retransmit),
-    //     .uart_dat_i   (data),
-    //     .sys_clk_i    (CLK), 
-    //     .sys_rst_i    (!booted),  
-    // );
-
-
-    // Use SPI pins (MOSI, MISO, CLK) to select channel data to send, 3b MUX
-    // assign data = eventCount[{gpioSDO, gpioSDI, gpioSCK}];
-    // assign data = eventCount[0];
-
-
-    // always @(negedge uartBusy) begin
-    //     retransmit = 0;
-    //     if(sendingByte == 0) begin
-    //         retransmit = 0;
-    //     end else begin
-    //         data = eventCount[eventSel];
-    //         sendingByte = ~sendingByte;
-    //         retransmit = 1; 
-    //     end
-    // end
+    // Coincidence outputs 0-3, programmed over SPI (coincidenceRegs.v).
+    // They start as CH0&&CH1, CH0&&CH2, CH1&&CH2, CH0&&CH1&&CH2.
+`ifdef LP384
+    localparam WINDOW_BITS = 8;
+`else
+    localparam WINDOW_BITS = 16;
+`endif
+    wire regStage;
+    wire regWrite;
+    wire [2:0] regAddr;
+    wire [31:0] regData;
+    wire regCommit;
+    wire [31:0] regs;
+    wire [3:0] coinc;
+    coincidenceRegs #(.WINDOW_BITS (WINDOW_BITS)) COINC(
+        .CLK      (CLK),
+        .rst      (!booted),
+        .raw      ({CH3_R, CH2_R, CH1_R, CH0_R}),
+        .stage    (regStage),
+        .wr       (regWrite),
+        .wrAddr   (regAddr),
+        .wrData   (regData),
+        .commit   (regCommit),
+        .addr     (bankWord),
+        .readData (regs),
+        .out      (coinc),
+    );
+
+    // The LP384 (Makefile DEVICE=384) has room for the registers alone:
+    // the bank reads zeros and the drain answers no status word.
+    wire latch;
+    wire [2:0] bankWord;
+    wire fifoPop;
+`ifdef LP384
+    localparam HAS_HITS = 0;
+    localparam HAS_BANK = 0;
+    wire [31:0] shadowOut = 0;
+    wire [31:0] fifoHead = 0;
+    wire fifoEmpty = 1;
+    wire [15:0] fifoFill = 0;
+    wire [31:0] fifoNow = 0;
+`else
+    localparam HAS_HITS = 1;
+    localparam HAS_BANK = 1;
+
+    // Counter bank for the Pi, read over the SPI pins that upload the
+    // bitstream (gpioSS is the Pi's GPIO24). Words 0-3 count the raw
+    // channels, 4-7 the coincidence outputs.
+    wire [31:0] shadow0;
+    wire [31:0] shadow1;
+    wire [31:0] shadow2;
+    wire [31:0] shadow3;
+    wire [31:0] shadow4;
+    wire [31:0] shadow5;
+    wire [31:0] shadow6;
+    wire [31:0] shadow7;
+    wire [31:0] count0;
+    wire [31:0] count1;
+    wire [31:0] count2;
+    wire [31:0] count3;
+    wire [31:0] count4;
+    wire [31:0] count5;
+    wire [31:0] count6;
+    wire [31:0] count7;
+    latchedCounter BANK0(.CLK (CLK), .in (CH0_R), .latch (latch), .shadow (shadow0), .count (count0));
+    latchedCounter BANK1(.CLK (CLK), .in (CH1_R), .latch (latch), .shadow (shadow1), .count (count1));
+    latchedCounter BANK2(.CLK (CLK), .in (CH2_R), .latch (latch), .shadow (shadow2), .count (count2));
+    latchedCounter BANK3(.CLK (CLK), .in (CH3_R), .latch (latch), .shadow (shadow3), .count (count3));
+    latchedCounter BANK4(.CLK (CLK), .in (coinc[0]), .latch (latch), .shadow (shadow4), .count (count4));
+    latchedCounter BANK5(.CLK (CLK), .in (coinc[1]), .latch (latch), .shadow (shadow5), .count (count5));
+    latchedCounter BANK6(.CLK (CLK), .in (coinc[2]), .latch (latch), .shadow (shadow6), .count (count6));
+    latchedCounter BANK7(.CLK (CLK), .in (coinc[3]), .latch (latch), .shadow (shadow7), .count (count7));
+
+    reg [31:0] shadowOut;
+    always @(*) begin
+        case (bankWord)
+            3'd0: shadowOut = shadow0;
+            3'd1: shadowOut = shadow1;
+            3'd2: shadowOut = shadow2;
+            3'd3: shadowOut = shadow3;
+            3'd4: shadowOut = shadow4;
+            3'd5: shadowOut = shadow5;
+            3'd6: shadowOut = shadow6;
+            default: shadowOut = shadow7;
+        endcase
+    end
+
+    // Every raw hit stamped with the tick counter, drained over the same pins.
+    // The Makefile sizes the FIFO to the part's block RAM.
+`ifndef FIFO_DEPTH_BITS
+`define FIFO_DEPTH_BITS 11
+`endif
+    wire [31:0] fifoHead;
+    wire fifoEmpty;
+    wire [15:0] fifoFill;
+    wire [31:0] fifoNow;
+    hitFifo #(.DEPTH_BITS (`FIFO_DEPTH_BITS)) HITS(
+        .CLK   (CLK),
+        .hits  ({CH3_R, CH2_R, CH1_R, CH0_R}),
+        .pop   (fifoPop),
+        .head  (fifoHead),
+        .empty (fifoEmpty),
+        .fill  (fifoFill),
+        .now   (fifoNow),
+    );
+
+`endif
+
+    counterSpi #(.HITS (HAS_HITS), .BANK (HAS_BANK)) COUNTERS(
+        .CLK       (CLK),
+        .SCK       (gpioSCK),
+        .SS        (gpioSS),
+        .SDI       (gpioSDO),
+        .SDO       (gpioSDI),
+        .latch     (latch),
+        .word      (bankWord),
+        .shadow    (shadowOut),
+        .pop       (fifoPop),
+        .fifoHead  (fifoHead),
+        .fifoEmpty (fifoEmpty),
+        .fifoFill  (fifoFill),
+        .fifoNow   (fifoNow),
+        .regStage  (regStage),
+        .regWrite  (regWrite),
+        .regAddr   (regAddr),
+        .regData   (regData),
+        .regCommit (regCommit),
+        .regs      (regs),
+    );
+
+`ifndef LP384
+    // Telemetry frame of the running counts once a second on uartTx
+    // (telemetry.v), 115200 baud 8N1. Not gpio23: that pin reaches the
+    // Pi's GPIO23, the bitstream upload's DONE input, which is no UART RX.
+    wire secPulse;
+    realClock #(.CYCLES_PER_MS (CLK_HZ / 1000)) REAL0(
+        .CLK      (CLK),
+        .secPulse (secPulse),
+    );
+
+    wire uartBusy;
+    wire uartWr;
+    wire [7:0] uartData;
+    wire [2:0] telemetryWord;
+    reg [31:0] telemetryCount;
+    always @(*) begin
+        case (telemetryWord)
+            3'd0: telemetryCount = count0;
+            3'd1: telemetryCount = count1;
+            3'd2: telemetryCount = count2;
+            3'd3: telemetryCount = count3;
+            3'd4: telemetryCount = count4;
+            3'd5: telemetryCount = count5;
+            3'd6: telemetryCount = count6;
+            default: telemetryCount = count7;
+        endcase
+    end
+    telemetry TELEMETRY(
+        .CLK   (CLK),
+        .rst   (!booted),
+        .start (secPulse),
+        .word  (telemetryWord),
+        .count (telemetryCount),
+        .busy  (uartBusy),
+        .wr    (uartWr),
+        .data  (uartData),
+    );
+    uart #(.CLK_HZ (CLK_HZ), .BAUD (115200)) UART0(
+        .uart_busy  (uartBusy),
+        .uart_tx    (uartTx),
+        .uart_wr_i  (uartWr),
+        .uart_dat_i (uartData),
+        .sys_clk_i  (CLK),
+        .sys_rst_i  (!booted),
+    );
+`endif
 
     // always @(posedge CH0_R) begin
     //     eventCount[0] = eventCount[0] + 1;
@@ -141,9 +283,10 @@ module top (
     // assign gpio18 = CH0_R && CH3_R;
     // assign gpio17 = CH2_R && CH3_R;
 
-    assign gpio27 = CH2_R;
-    assign gpio18 = CH2_R;
-    assign gpio17 = CH2_R;
+    // The Pi's coincidence inputs (channelMap.h)
+    assign gpio27 = coinc[0];
+    assign gpio18 = coinc[1];
+    assign gpio17 = coinc[2];
 
 endmodule
 